@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/graph.h"
+
+// ALT (A*, landmarks, triangle inequality) lower bounds for the a and b link metrics. The
+// distances from and to a few landmarks are computed once per graph; afterwards, a lower bound on
+// the distance between any two nodes costs O(#landmarks) and no search at all.
+class landmarks {
+ public:
+  enum class strategy { random, farthest };
+
+  // picks count landmarks and computes their distance tables (one-to-all searches in parallel)
+  void select(size_t count, strategy s, unsigned seed = 42);
+  // tables are only loaded if they were selected for the same graph, requested count and strategy
+  bool load(const std::string& path, uint64_t fingerprint, size_t count, strategy s);
+  // count is the number of landmarks requested from select
+  void save(const std::string& path, uint64_t fingerprint, size_t count, strategy s) const;
+  size_t size() const { return chosen.size(); }
+  const std::vector<int>& nodes() const { return chosen; }
+
+  // lower bound on the m-distance from v to w
+  double lower_bound(metric m, int v, int w) const;
+  // bound[v] <= m-distance from v to anchor (to_anchor) or from anchor to v, for all nodes v
+  void fill_bounds(int anchor, bool to_anchor, metric m, std::vector<double>& bound) const;
+
+ private:
+  std::vector<int> chosen;
+  size_t n = 0;
+  // node-major, for metric a (0) and b (1): from[m][v * size() + l] = distance from landmark l
+  // to v, to[m][v * size() + l] = distance from v to landmark l
+  std::vector<double> from[2], to[2];
+};
+
+// hash of the topology and the a/b weights of all links, to recognise stale landmark files
+uint64_t graph_fingerprint();
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/data.h"
+
+// Customizable contraction hierarchy (CCH). The node order (nested dissection on the node
+// coordinates) and the contracted graph only depend on the topology, so they are computed once
+// per graph. The link weights are brought in afterwards by customizing a cch_metric, which takes
+// a fraction of the preprocessing time and can be repeated for every metric (b, latency(k), ...).
+class cch {
+ public:
+  void build();  // orders and contracts the current graph (adj, adj_inv and nodes)
+  bool load(const std::string& path, uint64_t fingerprint);
+  void save(const std::string& path, uint64_t fingerprint) const;
+  size_t size() const { return rank.size(); }
+  size_t arcs() const { return up_head.size(); }
+
+ private:
+  friend class cch_metric;
+  // Everything below is indexed by rank. The upward arcs of r are [first_up[r], first_up[r + 1])
+  // with their heads sorted ascending; arc_tail is the lower end of every arc.
+  std::vector<int> rank, node_at, parent;  // parent in the elimination tree, -1 for roots
+  std::vector<int> first_up, up_head, arc_tail;
+  std::vector<int> first_down, down_tail, down_arc;  // lower neighbours and the arcs to them
+  // ranks grouped by their height in the elimination tree (leaves first): the arcs of the nodes
+  // of one level only depend on arcs of lower levels, so a level is customized in parallel
+  std::vector<int> level_start, by_level;
+  std::unordered_map<int, link*> links_by_id;
+  void finish();  // derives parent, arc_tail, the downward lists, the levels and links_by_id
+  int find_arc(int lower, int upper) const;  // -1 if there is no such arc
+};
+
+// One metric on a cch. Queries use scratch space of the metric, so they are not thread-safe.
+class cch_metric {
+ public:
+  cch_metric(const cch& hierarchy, std::function<double(link*)> weight);
+  // copy of this metric in which the excluded links do not exist (partial re-customization)
+  cch_metric without(const std::unordered_map<int, bool>& excluded) const;
+  // shortest path from -> to, nullptr if there is none
+  std::shared_ptr<route> query(int from, int to) const;
+  // PHAST: distances from source to every node (forward) or from every node to source
+  void one_to_all(int source, bool forward, std::vector<double>& dist) const;
+
+ private:
+  const cch* h;
+  std::function<double(link*)> weight;
+  std::unordered_map<int, bool> excluded;
+  // per arc: weight upwards (tail -> head) and downwards, and the middle node of the shortcut
+  // (-1 if the weight is the one of the original link stored in up_link/down_link)
+  std::vector<double> up, down;
+  std::vector<int> up_mid, down_mid;
+  std::vector<link*> up_link, down_link;
+  mutable std::vector<double> forward_dist, backward_dist;
+  mutable std::vector<int> forward_pred, backward_pred;
+  void customize();
+  bool initial_weights(int arc);  // weights of the original links of arc, returns if changed
+  bool relax_triangle(int lower, int arc_lower_tail, int arc_lower_head, int arc);
+  void unpack(int arc, bool upward, std::vector<link*>& links) const;
+};
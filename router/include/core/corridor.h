@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/data.h"
+
+// Restricts the graph (adj, adj_inv and nodes) to a corridor around one OD pair, so that all
+// searches of the OD group run on a small renumbered copy and size their arrays to it. While a
+// corridor is active, node ids are local and links are copies with local from/to; the link ids
+// stay the global ones. Routes found inside are mapped back with to_global.
+class corridor {
+ public:
+  // Corridor kinds: "distance" keeps the nodes v with b(from, v) + b(v, to) <= (1 + slack) *
+  // b(from, to) (two one-to-all searches on the full graph), "ellipse" the nodes whose Euclidean
+  // distances to from and to add up to at most (1 + slack) times the one between them (no
+  // search). Stays on the full graph and returns false for "none" or if the corridor
+  // disconnects from and to.
+  bool enter(int from, int to, const std::string& kind, double slack);
+  void leave();
+  bool active() const { return entered; }
+  size_t size() const { return global_of.size(); }
+  int local(int v) const { return entered ? local_of[v] : v; }  // -1 outside of the corridor
+  int global(int v) const { return entered ? global_of[v] : v; }
+  route to_global(const route& r) const;
+  // runs f on the full graph while a corridor is active (e.g. to write intermediate plans)
+  template <class F>
+  void outside(F f) {
+    if (entered)
+      swap_graph();
+    f();
+    if (entered)
+      swap_graph();
+  }
+
+ private:
+  bool entered = false;
+  std::vector<std::vector<link*>> local_adj, local_adj_inv;
+  std::vector<node*> local_nodes;
+  std::vector<int> local_of, global_of;
+  std::vector<link> local_links;  // copies of the links inside, with local from/to
+  std::vector<link*> original;    // the link each copy was made from
+  void restrict_to(const std::vector<bool>& keep);
+  void swap_graph();
+};
+
+extern corridor od_corridor;  // the corridor of the OD group being routed
+
+// Reads the corridor kind and slack from the env variables <prefix>_CORRIDOR and
+// <prefix>_CORRIDOR_SLACK (SSOTD or EA). Unknown kinds and negative slacks fall back to the
+// defaults with a warning.
+void parse_corridor_env(const std::string& prefix, const std::string& default_kind,
+                        double default_slack, std::string& kind, double& slack);
@@ -63,6 +63,7 @@ struct person {
 class ParetoElement {
  private:
   double _a = 0.0, _b = 0.0, _shared_a = 0.0, _shared_b = 0.0, _taud = 0.0, _shared_taud = 0.0;
+  double _cover = 1.0;  // approximation factor of the labels this one replaced (epsilon-dominance)
   std::shared_ptr<ParetoElement> parent = nullptr;
 
  public:
@@ -72,6 +73,9 @@ class ParetoElement {
   ParetoElement(std::shared_ptr<ParetoElement> par, link* l);
   ParetoElement(std::shared_ptr<ParetoElement> par, link* l, bool shared);
   ParetoElement(double a, double b, double taud, double sa, double sb, double staud);
+  // a stored label (front cache): the values as given
+  ParetoElement(std::shared_ptr<ParetoElement> par, link* l, double a, double b, double taud,
+                double sa, double sb, double staud, double cover);
   double a() const;
   double b() const;
   double taud() const;
@@ -84,4 +88,8 @@ class ParetoElement {
   std::shared_ptr<route> collectRoute();
   ParetoElement(std::shared_ptr<ParetoElement> par);  // recursive memory copy
   void set_parent(const std::shared_ptr<ParetoElement> par);
+  void cover(double factor);  // this label now stands in for paths up to factor times better
+  double approx() const;      // worst approximation factor along the path
+  double own_cover() const;   // approximation factor of this label alone, without its prefixes
+  const std::shared_ptr<ParetoElement>& get_parent() const;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "core/data.h"
+
+// The Pareto set of labels at one node. Next to the labels, their dominance criteria (those of
+// the 2r models: b, taud and, for strong dominance, shared_a) are stored in contiguous arrays, so
+// that a new label is compared to 4 (AVX2) or 8 (AVX-512) stored labels per instruction. Build
+// with NATIVE=1 to enable the vector kernels, otherwise a scalar loop is used.
+class label_front {
+ public:
+  using labels_type = std::vector<std::shared_ptr<ParetoElement>>;
+
+  size_t size() const { return labels.size(); }
+  bool empty() const { return labels.empty(); }
+  labels_type::iterator begin() { return labels.begin(); }
+  labels_type::iterator end() { return labels.end(); }
+  labels_type::const_iterator begin() const { return labels.begin(); }
+  labels_type::const_iterator end() const { return labels.end(); }
+  std::shared_ptr<ParetoElement>& back() { return labels.back(); }
+  std::shared_ptr<ParetoElement>& operator[](size_t i) { return labels[i]; }
+  operator const labels_type&() const { return labels; }
+
+  void push_back(std::shared_ptr<ParetoElement> par);  // appends without any dominance test
+  void swap(label_front& other);
+
+  // Inserts par unless a stored label (1 + eps)-dominates it, in which case the first such label
+  // is returned. Otherwise, the stored labels par (1 + eps)-dominates are removed (and appended to
+  // removed, if given) and nullptr is returned. Tests and removal mask are one pass.
+  std::shared_ptr<ParetoElement> insert(std::shared_ptr<ParetoElement>& par, bool strong,
+                                        double eps, labels_type* removed = nullptr);
+
+ private:
+  labels_type labels;
+  std::vector<double> b, taud, shared_a;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "core/graph.h"
+
+// Lower bounds from the node coordinates. No link is cheaper per unit of straight-line distance
+// than the cheapest link of the graph, so by the triangle inequality the distance between two
+// nodes is at least their Euclidean distance times that factor. A bound array costs O(#nodes)
+// and no search at all, but the bounds are weaker than the ones of a search or ALT.
+class geometric_bounds {
+ public:
+  void prepare();  // reads the coordinates and the factors of the full graph
+  bool ready() const { return prepared; }
+  // bound[v] <= m-distance between v and anchor (in either direction), m is a or b
+  void fill_bounds(int anchor, metric m, std::vector<double>& bound) const;
+
+ private:
+  bool prepared = false;
+  std::vector<double> x, y;  // by global node id
+  double per_distance[2] = {0.0, 0.0};  // minimum a (0) and b (1) per unit of distance
+};
@@ -10,6 +10,7 @@
 extern std::vector<person> persons;
 extern std::vector<node*> nodes;
 extern std::vector<std::vector<link*>> adj;
+extern std::vector<std::vector<link*>> adj_inv;  // incoming links of each node, built with adj
 
 extern int number_agents;
 
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+
+// Read-only view of the graph for searches in one direction: the outgoing links of each node
+// (forward) or its incoming links (backward), in which case a search continues at link->from.
+struct graph_view {
+  const std::vector<std::vector<link*>>& links;
+  bool forward;
+  size_t size() const { return links.size(); }
+  const std::vector<link*>& operator[](int v) const { return links[v]; }
+  int head(const link* l) const { return forward ? l->to : l->from; }
+};
+
+graph_view forward_graph();   // adj
+graph_view backward_graph();  // adj_inv
+
+// link weights the one-to-all searches can compute distances for
+enum class metric { a, b, taud };
+
+// One-to-all shortest distances from (forward view) or to (backward view) source for up to three
+// metrics at once. Every metric gets its own shortest path distances, but all of them are
+// computed in a single traversal that shares the queue and the adjacency scans. The distances are
+// written into the caller's arrays, which are resized to the number of nodes. Links in inactive
+// are skipped.
+void one_to_all(int source, const graph_view& graph,
+                const std::vector<std::pair<metric, std::vector<double>*>>& targets,
+                const std::unordered_map<int, bool>& inactive = std::unordered_map<int, bool>());
+
+// Same as one_to_all, but from (or to) several sources at once. Each source starts at its own
+// distance in every metric (in the order of targets), e.g. the remaining cost from there on.
+void many_to_all(const std::vector<std::pair<int, std::vector<double>>>& sources,
+                 const graph_view& graph,
+                 const std::vector<std::pair<metric, std::vector<double>*>>& targets,
+                 const std::unordered_map<int, bool>& inactive = std::unordered_map<int, bool>());
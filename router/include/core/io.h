@@ -1,11 +1,13 @@
 #pragma once
 
+#include <string>
 #include <tinyxml2.h>
 
 void readPersons(const tinyxml2::XMLDocument&);
-void loadGraph(const char* graphFile);
+void loadGraph(const char* graphFileName);
 void loadPlans(const char* plansFile);
 void outputPlans(const char* plansFile);
 void outputPlansToNewFile(const char* plansFile);
 
 extern tinyxml2::XMLDocument plansXml;
+extern std::string graphFile;  // path of the loaded graph, auxiliary files are stored next to it
@@ -1,4 +1,6 @@
 #pragma once
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "core/data.h"
@@ -7,16 +9,24 @@ using namespace std;
 
 class psychmod {
  public:
+  virtual ~psychmod() = default;
   virtual double b(link& l) = 0;
   virtual double a(link& l) = 0;
   virtual double latency(double a, double b, double x) = 0;
   virtual vector<double> calc_usage(double ap, double bp, double aq, double bq, double apnq,
                                     double bpnq, int k) = 0; //apnq and bpnq refer tp the parameters a and b of the shared edges of p and q while the others refer to the whole paths p and q
-  virtual bool dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2) = 0;
-  virtual bool strongly_dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2) = 0;
+  // eps > 0 tests for multiplicative epsilon-dominance, i.e. par1 <= (1 + eps) * par2 in every criterion
+  virtual bool dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2, double eps = 0.0) = 0;
+  virtual bool strongly_dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2, double eps = 0.0) = 0;
   pair<double, int> score_route(route& p, route& q, int k);
   pair<double, int> score_route(double ap, double bp, double aq, double bq, double apnq,
                                     double bpnq, int k);
+  // Scores n alternatives against the same route q at once, their parameters given as arrays
+  // (ap[i], bp[i], apnq[i], bpnq[i] of alternative i). Writes what score_route returns for each.
+  // The default scores them one by one; models with a closed-form usage override it.
+  virtual void score_routes(size_t n, const double* ap, const double* bp, double aq, double bq,
+                            const double* apnq, const double* bpnq, int k, double* scores,
+                            int* usages);
                                     
   pair<double, double> score_routes_individually(route& p, route& q, int k);
 };
@@ -28,18 +38,29 @@ class linear_simple_example_model_2r : public psychmod {
   virtual double latency(double a, double b, double x);
   virtual vector<double> calc_usage(double ap, double bp, double aq, double bq, double apnq,
                                     double bpnq, int k);
-  virtual bool dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2);
-  virtual bool strongly_dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2);
+  virtual bool dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2, double eps = 0.0);
+  virtual bool strongly_dominating(shared_ptr<ParetoElement> par1, shared_ptr<ParetoElement> par2, double eps = 0.0);
 };
 
 class user_equilibrium_2r : public linear_simple_example_model_2r {
  public:
   virtual vector<double> calc_usage(double ap, double bp, double aq, double bq, double apnq,
                                     double bpnq, int k);
+  // solves the quadratic of calc_usage for all alternatives in one vectorizable loop
+  virtual void score_routes(size_t n, const double* ap, const double* bp, double aq, double bq,
+                            const double* apnq, const double* bpnq, int k, double* scores,
+                            int* usages);
 };
 
 class system_optimum_2r : public linear_simple_example_model_2r {
  public:
   virtual vector<double> calc_usage(double ap, double bp, double aq, double bq, double apnq,
                                     double bpnq, int k);
+  // solves the quadratic of calc_usage for all alternatives in one vectorizable loop
+  virtual void score_routes(size_t n, const double* ap, const double* bp, double aq, double bq,
+                            const double* apnq, const double* bpnq, int k, double* scores,
+                            int* usages);
 };
+
+// the model class of the given name (as for PSYCHMOD), nullptr if there is none
+unique_ptr<psychmod> make_psychmod(const string& name);
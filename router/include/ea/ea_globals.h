@@ -16,4 +16,6 @@ extern int queue_size;
 extern individual (*crossover_func)(individual&, individual&, int);
 extern std::string crossover_func_str;
 extern std::string intermediate_results_prefix;
-extern std::string intermediate_folder;
\ No newline at end of file
+extern std::string intermediate_folder;
+extern std::string corridor_kind;  // corridor of each OD group: none, distance or ellipse
+extern double corridor_slack;      // how much longer than the direct connection it may be
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+
+// The Pareto fronts of an OD group, keyed by the indices on the original route where their paths
+// leave and rejoin it. Variants with a single search from origin to destination use one entry.
+using front_map = std::map<std::pair<int, int>, std::vector<std::shared_ptr<ParetoElement>>>;
+
+// The slot of one OD group in the front cache (SSOTD_FRONT_CACHE). The key covers everything the
+// fronts depend on: the graph as it is searched (graph_fingerprint, so within the corridor if
+// there is one), the variant, origin, destination, agent count, psychological models, original
+// route and the settings that change which labels a search keeps. Each slot is one file of the
+// cache directory. The labels and their prefixes are stored once each, in binary. Past
+// SSOTD_FRONT_CACHE_MB, the least recently used files are removed. Does nothing if there is no
+// cache directory.
+class front_cache_slot {
+ public:
+  front_cache_slot(const std::string& variant, int a, int b, int k, const route& original_route);
+  // fills fronts from the cache, false if the slot is empty (or unreadable)
+  bool load(front_map& fronts);
+  // stores the fronts of an exhaustive search
+  void store(const front_map& fronts);
+
+ private:
+  uint64_t key = 0;
+  std::string path;
+};
+
+void print_front_cache_stats();  // hits, misses, stores and evictions of this run
@@ -1,10 +1,17 @@
 #pragma once
 #include <any>
+#include <cmath>
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
+#include "core/ch.h"
 #include "core/data.h"
+#include "core/front.h"
+#include "core/graph.h"
+#include "core/psychmod.h"
 
 using namespace std;
 void fill_best_pars_dijkstra(int to, unordered_map<int, bool> inactive=unordered_map<int, bool>());
@@ -17,51 +24,274 @@ extern vector<double> origTt, origPartA, origPartB;  // original route prefix su
 
 extern unordered_map<int, int> nodes_original_route;  // maps a node id to its index in orig route
 
+// cheapest way from a node back onto the original route (avoiding its links) plus the rest of it
+extern vector<double> rejoinAs, rejoinBs;
+
+// fills rejoinAs and rejoinBs, needs the prefix sums of prepare_original_route
+void fill_rejoin_bounds(shared_ptr<route> original_route, const unordered_map<int, bool>& inactive);
+
+// if l is a link of the original route (prepare_original_route has to be called before)
+bool on_original_link(link* l, shared_ptr<route> original_route);
+
+// The lower bounds a label can be pruned by: the cost to the destination (bestAs, bestBs), the
+// cost of rejoining the original route and following it (rejoinAs, rejoinBs), and the exact rest
+// of a label that has rejoined the original route for good (origPartA, origPartB).
+enum class bound_rule { target, rejoin, suffix };
+
+// What the last call of a lower_bound_score function, which combines the rules, found: the bound
+// of the target rule alone and the rule that tightened it (target if none did). The searches use
+// it to count which rule pruned a label.
+struct bound_trace {
+  bound_rule rule = bound_rule::target;
+  double target_bound = HUGE_VAL;
+};
+extern thread_local bound_trace last_bound;
+
+// restricts the graph to the corridor of the OD group (SSOTD_CORRIDOR), source and destination
+// become ids in the corridor
+void enter_od_corridor(int& source, int& destination);
+
+// maps the routes of the persons of the OD group back to the full graph and leaves the corridor
+void leave_od_corridor(const vector<int>& pids);
+
+// The persons with the same origin, destination and time, which do_routing routes together.
+struct od_group {
+  int origin, destination;
+  string time;
+  vector<int> pids;
+};
+
+// The OD groups in the order they are routed in: by origin, destination and time, or by
+// destination first if the bound cache (SSOTD_BOUND_CACHE, not in corridors) can reuse the bounds
+// of the previous group. The order decides for which group the links cache their latency
+// (link::taud) and in which order the persons draw their routes.
+vector<od_group> od_groups();
+
 shared_ptr<route> dijkstra(int a, int b, shared_ptr<route> original_route = nullptr);
 
+// shortest route from a to b avoiding the links of original_route by the latency of the links at
+// x agents, i.e. with a penalty on the links that congest quickly
+shared_ptr<route> latency_dijkstra(int a, int b, shared_ptr<route> original_route, double x);
+
+// Sets number_agents to k for its lifetime, with fresh latencies cached by the links
+// (link::taud). Afterwards, the count and the latencies the links had cached before are restored,
+// so that the OD groups routed later see the same latencies as without it.
+class agent_count_scope {
+ public:
+  explicit agent_count_scope(int k);
+  ~agent_count_scope();
+  agent_count_scope(const agent_count_scope&) = delete;
+  agent_count_scope& operator=(const agent_count_scope&) = delete;
+
+ private:
+  int saved_count;
+  vector<double> saved_taud;  // by link, in the order of adj
+};
+
+// the contraction hierarchy customized for metric (metric::taud stands for latency(k)),
+// built and customized on first use
+const cch_metric& customized(metric m, int k = 0);
+
+// What a Pareto search reports besides its label sets. Only filled if the caller passes one.
+struct search_info {
+  bool timed_out = false;                  // the deadline passed before the queue was empty
+  bool over_budget = false;                // labels were merged or dropped to stay in the budget
+  double lower_bound = HUGE_VAL;           // lowest lower bound OT of the labels left unexplored
+  double relaxed_ot = HUGE_VAL;            // best complete alternative seen when relaxing qot
+  shared_ptr<ParetoElement> relaxed_par;   // its detour from the original route
+  int relaxed_from = -1, relaxed_to = -1;  // nodes where the detour leaves / rejoins the original
+  long long pruned[3] = {0, 0, 0};         // labels pruned, by the bound_rule that pruned them
+  long long revisits = 0;                  // extensions rejected for revisiting a node
+  // label statistics (SSOTD_STATS), not counted if built with SSOTD_NO_STATS
+  long long created = 0;    // extensions within the OT cap, i.e. offered to a Pareto set
+  long long dominated = 0;  // of these the rejected ones, plus the labels they removed
+  long long pushes = 0, pops = 0;  // of the queue
+  void merge(const search_info& other);
+  bool exhaustive() const { return !timed_out && !over_budget; }
+};
+
+// counts a pruned label for the rule that pruned it (see bound_trace)
+void count_pruned(search_info* info, double qot);
+
+void print_pruned(const search_info& info);
+
+// counts a label offered to a Pareto set of size before, which now has size after
+inline void count_label(search_info* info, bool inserted, size_t before, size_t after) {
+#ifndef SSOTD_NO_STATS
+  if (!info)
+    return;
+  info->created++;
+  info->dominated += inserted ? before + 1 - after : 1;
+  info->pushes += inserted;
+#else
+  (void) info; (void) inserted; (void) before; (void) after;
+#endif
+}
+
+// counts labels taken from the queue
+inline void count_pops(search_info* info) {
+#ifndef SSOTD_NO_STATS
+  if (info)
+    info->pops++;
+#else
+  (void) info;
+#endif
+}
+
+void start_deadline();  // starts the time budget (SSOTD_DEADLINE_MS) of the current OD group
+
+bool deadline_passed();
+
 bool standard_prio(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right);
  
 bool astar_prio_dijkstra(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right);
 
-pair<double, long long> pareto_dijkstra_local_opt(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+pair<double, long long> pareto_dijkstra_local_opt(int a, int from, int to, vector<label_front>& pareto,
                                shared_ptr<route> original_route, int k, double qot,
                                unordered_map<int, bool> inactive = unordered_map<int, bool>(),
                                pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                                            shared_ptr<route>, int) = nullptr,
-       bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)=&standard_prio);
+       bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)=&standard_prio,
+       search_info* info = nullptr);
+
+// Same search as pareto_dijkstra_local_opt, run on all OpenMP threads. It works in rounds: the
+// labels next in the queue are expanded and their extensions scored in parallel, then the labels
+// are popped and their extensions inserted one after the other, in the order of the sequential
+// search, until the top of the queue is a label that was not expanded yet. The Pareto sets, the
+// OT and the visits are the same as those of the sequential search with the same prio. If the
+// bound depends on the state of the search (rescore, the caps of SSOTD_MODELS and SSOTD_K_SWEEP
+// in fulldisjoint), the extensions are scored once more when they are inserted.
+pair<double, long long> pareto_dijkstra_parallel(int a, int from, int to, vector<label_front>& pareto,
+                                                 shared_ptr<route> original_route, int k, double qot,
+                                                 const unordered_map<int, bool>& inactive,
+                                                 pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
+                                                                                           shared_ptr<route>, int),
+                                                 bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                                                 bool rescore = false,
+                                                 search_info* info = nullptr);
+
+// A label of the compact search (SSOTD_COMPACT_LABELS), 28 bytes. Its criteria are floats,
+// rounded down (lo) and up (hi) by one more float step at every extension, so that they enclose
+// the double sums of the same path as a ParetoElement. A label is only dropped if the hi values
+// of another one are at most its lo values, i.e. if that one dominates it for sure. Parent and
+// link are 32-bit indices.
+struct compact_label {
+  float a_lo, b_lo, b_hi, taud_lo, taud_hi;
+  uint32_t parent;  // in compact_search::labels, compact_search::none for the start label
+  uint32_t link;    // in compact_search::links, compact_search::none for the start label
+};
+
+// The labels of a compact search, which are never freed, and its Pareto sets as label indices
+struct compact_search {
+  static constexpr uint32_t none = UINT32_MAX;
+  vector<compact_label> labels;
+  vector<link*> links;  // all links, numbered by their position in adj
+  vector<vector<uint32_t>> pareto;
+  size_t queue_peak = 0;
+  size_t bytes() const;  // of labels, links, Pareto sets and queue (at its peak)
+  // the exact a and b of the path, summed like the ParetoElements of the same path
+  pair<double, double> exact_ab(uint32_t label) const;
+  shared_ptr<ParetoElement> materialize(uint32_t label) const;  // the path as ParetoElements
+};
 
-long long pareto_dijsktra(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
+// pareto_dijkstra_local_opt with astar_prio_dijkstra on compact labels. lower_bound_score gets the
+// a and b of a path from a to v: the rounded down ones, at to the exact ones, whose score can
+// relax qot. Exact dominance only, SSOTD_EPSILON and SSOTD_LABEL_BUDGET do not apply.
+pair<double, long long> pareto_dijkstra_compact(int a, int to, compact_search& search,
+                                                shared_ptr<route> original_route, int k, double qot,
+                                                const unordered_map<int, bool>& inactive,
+                                                pair<double, double> (*lower_bound_score)(double, double, int, int,
+                                                                                          shared_ptr<route>, int),
+                                                search_info* info = nullptr);
+
+// Best alternative of a bidirectional search, joined at a meeting node v from a forward label
+// (a -> v) and a backward label (v -> b, its links collected from b towards v).
+struct bidirectional_result {
+  double ot = HUGE_VAL;
+  double usage = 0.0;
+  shared_ptr<ParetoElement> forward, backward;
+  long long forward_visits = 0, backward_visits = 0;
+  long long forward_labels = 0, backward_labels = 0;
+  long long meetings = 0;  // complete candidates scored at meeting nodes
+  bool stopped_early = false;  // stopped with labels left whose own bound is below the cap
+  shared_ptr<route> collectRoute() const;
+};
+
+// Pareto search for the best alternative from a to b that avoids the inactive links, run from
+// both ends at once (on adj from a, on adj_inv from b). Needs the bounds towards b (bestAs,
+// bestBs) and from a (bestAsForward, bestBsForward). Exact, like pareto_dijkstra_local_opt.
+bidirectional_result pareto_dijkstra_bidirectional(int a, int b, shared_ptr<route> original_route,
+                                                   int k, double qot,
+                                                   unordered_map<int, bool> inactive,
+                                                   search_info* info = nullptr);
+
+long long pareto_dijsktra(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
        bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)=&standard_prio);
 
-long long pareto_dijsktra_4d(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
+long long pareto_dijsktra_4d(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
        bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)=&standard_prio);
 
-void pareto_dijsktra_4d_1D(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
+void pareto_dijsktra_4d_1D(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route, unordered_map<int, bool> inactive=unordered_map<int, bool>(),
        bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)=&standard_prio);
 
-pair<double, long long> pareto_dijkstra_local_opt_4d(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+pair<double, long long> pareto_dijkstra_local_opt_4d(int a, int from, int to, vector<label_front>& pareto,
                                shared_ptr<route> original_route, int k, double qot, unordered_map<int, bool> is_orig_edge,
                                pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                                            shared_ptr<route>, int),
-                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>));
+                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                     search_info* info = nullptr);
 
-pair<double, long long> pareto_dijkstra_local_opt_4d_1D(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+pair<double, long long> pareto_dijkstra_local_opt_4d_1D(int a, int from, int to, vector<label_front>& pareto,
               shared_ptr<route> original_route, int k, double qot, unordered_map<int, bool> is_orig_edge,
               pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                           shared_ptr<route>, int),
-bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>));
+bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+search_info* info = nullptr);
 
 
-shared_ptr<vector<double>> dijkstra_for_opt(int v, bool doA, unordered_map<int, bool> inactive, vector<vector<link*>> adj, bool forward);
 
 bool insert_and_dominate(list<shared_ptr<ParetoElement>>& A, shared_ptr<ParetoElement>& frag);
 
+// inserts newPar into the Pareto set of its node unless it is dominated; returns if it was inserted
+bool insert_label(label_front& front, shared_ptr<ParetoElement>& newPar,
+                  bool strong, double eps);
+
+// worst-case factor by which the labels of an epsilon-dominance search may be off in every
+// dominance criterion compared to the exact Pareto set (1 for exact searches)
+double approximation_bound(const vector<shared_ptr<ParetoElement>>& front);
+
 double score_for_relax(int idc, int idv, shared_ptr<ParetoElement> par, double k);
 
+// The alternatives of an evaluation phase, stored as arrays so that they can be scored in one
+// batch (psychmod::score_routes) instead of one score_route call each.
+struct candidate_batch {
+  vector<double> a, b, shared_a, shared_b;
+  vector<double> ots;  // filled by score
+  vector<int> usages;
+  size_t size() const { return a.size(); }
+  void push_back(double pa, double pb, double psa, double psb);
+  // scores all alternatives against the route with parameters aq and bq, in parallel blocks;
+  // with SSOTD_CHECK_SCORES, every score is compared to that of score_route
+  void score(double aq, double bq, int k);
+  void score(psychmod& model, double aq, double bq, int k);  // under another model
+  size_t best() const;  // first alternative with the lowest OT, size() if there is none
+};
+
 int index_in_original(int v);
 
 int is_orig_node(int node, shared_ptr<route> orig);
 
 void prepare_original_route(shared_ptr<route> original_route, unordered_map<int, bool>& inactive);
 
+// The best relaxed candidate of a search as a route: the original route up to where the detour
+// leaves it, the detour and the rest of the original route.
+shared_ptr<route> relaxed_route(const search_info& info, shared_ptr<route> original_route);
+
+// Result of an OD group whose searches were cut short (by the deadline or the label budget): the
+// better one of the selected alternative (if any) and the best relaxed candidate, flagged as
+// NON-OPTIMAL together with its gap to the lower bound.
+pair<shared_ptr<route>, double> best_so_far(const search_info& info, shared_ptr<route> original_route,
+                                            int k, double qot, shared_ptr<route> best,
+                                            double best_ot, double best_usage);
+
 void check_route_sanity(route& r, string routeName);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+static constexpr double default_pareto_epsilon = 0.0;
+static constexpr long long default_deadline_ms = 0;  // no deadline
+static constexpr long long default_label_budget = 0;  // unlimited
+// a search over the label budget first coarsens to epsilon-dominance, starting at
+// budget_start_epsilon and doubling up to budget_max_epsilon, before it drops queued labels
+static constexpr double budget_start_epsilon = 0.01;
+static constexpr double budget_max_epsilon = 0.16;
+static constexpr const char* default_bounds = "dijkstra";  // or alt, ch, geometric
+static constexpr int default_bound_cache = 4;
+static constexpr int default_landmarks = 16;
+static constexpr const char* default_landmark_strategy = "farthest";  // or random
+// also the defaults of EA_CORRIDOR and EA_CORRIDOR_SLACK
+static constexpr const char* default_corridor = "none";  // or distance, ellipse
+static constexpr double default_corridor_slack = 0.5;
+static constexpr long long default_front_cache_mb = 1024;
+static constexpr bool default_seed_bound = true;
+static constexpr const char* default_stats_format = "ndjson";  // or csv
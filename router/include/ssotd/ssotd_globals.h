@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+extern double pareto_epsilon;  // > 0 enables multiplicative epsilon-dominance in the Pareto searches
+extern long long deadline_ms;  // time budget per OD group in milliseconds, 0 for none
+extern long long label_budget;  // max. labels (Pareto sets and queue) per search, 0 for none
+extern std::string bound_mode;          // how the A* bounds are computed: dijkstra, alt, ch, geometric
+extern int landmark_count;              // number of ALT landmarks
+extern std::string landmark_strategy;  // how ALT landmarks are picked: farthest or random
+extern bool persist_landmarks;          // store the ALT tables next to the graph and reuse them
+extern bool use_ch;      // answer the single-criterion Dijkstras with a contraction hierarchy
+extern bool persist_ch;  // store the contraction hierarchy next to the graph and reuse it
+extern std::string corridor_kind;  // corridor of each OD group: none, distance or ellipse
+extern double corridor_slack;      // how much longer than the direct connection it may be
+extern int bound_cache_size;  // number of bound arrays kept for reuse, 0 for none
+extern bool bidirectional_search;  // fulldisjoint: search from origin and destination at once
+extern bool seed_bound;  // fulldisjoint: start with the OT of the disjoint Dijkstra route as cap
+extern bool simple_paths;  // reject labels whose path revisits a node
+extern bool parallel_search;  // fulldisjoint: one Pareto search on all OpenMP threads
+extern bool parallel_check;   // fulldisjoint: compare its Pareto sets to the sequential ones
+extern bool compact_labels;  // fulldisjoint: search with 28-byte float labels (compact_label)
+extern bool via_exact;  // via: run the fulldisjoint search as well and report the gap to it
+extern bool check_scores;  // compare the batch scores to those of score_route
+extern std::vector<std::string> evaluation_models;  // further models to score the results under
+extern std::string front_cache_dir;  // where the Pareto fronts are cached, empty for no caching
+extern long long front_cache_mb;     // size limit of the front cache in MiB
+extern std::vector<int> k_sweep;  // fulldisjoint: agent counts to solve every OD for, besides its own
+extern std::string stats_sink;    // file the per-query stats are appended to, - for stdout
+extern std::string stats_format;  // of the stats records: ndjson or csv
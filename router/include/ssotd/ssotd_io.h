@@ -0,0 +1,3 @@
+#pragma once
+
+extern void parse_ssotd_env();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+#include "ssotd/ssotd_core.h"
+
+// The statistics of one query, i.e. one OD group, written as one record to the sink of
+// SSOTD_STATS (NDJSON, or CSV with SSOTD_STATS_FORMAT=csv) when the query ends. The variants fill
+// in the phase timings and merge the search_info of their searches. Built with SSOTD_NO_STATS
+// (make STATS=0), the searches count no labels and no record is written.
+struct query_stats {
+  std::string variant;
+  int source = -1, destination = -1, k = 0;
+  long long precalc_us = 0, search_us = 0, evaluation_us = 0;
+  long long total_us = 0;  // from begin_query to end_query
+  long long visits = 0;
+  search_info search;  // the label counters of all searches of the query
+  // fronts by size: entry i counts the Pareto sets with 2^i to 2^(i+1) - 1 labels
+  std::vector<long long> front_sizes;
+  long long pareto_set = 0;  // alternatives evaluated
+  long peak_rss_kb = 0;      // of the process so far
+};
+
+extern query_stats current_query;
+
+// starts the record of a query (before the OD group enters its corridor)
+void begin_query(const std::string& variant, int source, int destination, int k);
+
+template <class Front>
+size_t front_size(const Front& front) {
+  return front.size();
+}
+
+template <class Key, class Front>
+size_t front_size(const std::pair<const Key, Front>& entry) {
+  return entry.second.size();
+}
+
+// counts the Pareto sets of a search (per node, or a front_map) by their size, leaving out the
+// empty ones
+template <class Fronts>
+void add_front_sizes(const Fronts& fronts) {
+#ifndef SSOTD_NO_STATS
+  for (auto& front : fronts) {
+    size_t size = front_size(front);
+    if (size == 0)
+      continue;
+    size_t bucket = 0;
+    while (size >>= 1)
+      bucket++;
+    if (current_query.front_sizes.size() <= bucket)
+      current_query.front_sizes.resize(bucket + 1, 0);
+    current_query.front_sizes[bucket]++;
+  }
+#else
+  (void) fronts;
+#endif
+}
+
+// Ends the query with the alternative its agents take, usage of them (none if it is the original
+// route), and writes its record, including the OT of that split.
+void end_query(std::shared_ptr<route> alternative, std::shared_ptr<route> original_route,
+               double usage);
@@ -0,0 +1,55 @@
+#!/bin/bash
+# Thread scaling of the parallel Pareto search of fulldisjoint (SSOTD_PARALLEL_SEARCH).
+#
+# usage: scripts/parallel_search_benchmark.sh <graph> <plans> [threads] [repetitions]
+#
+# Runs the router once with the sequential search and then with SSOTD_PARALLEL_SEARCH=1 for each
+# thread count (default "1 2 4 8 16 32 64"), each run repeated (default 3 times). It prints the
+# fastest search time of every setting, summed over the OD groups, with its node visits, rounds
+# and the summed OT. The visits and the OT have to be the same in every line. Build the router
+# beforehand, e.g. with `make TYPE=RELEASE NATIVE=1`; ROUTER selects another binary (default
+# ./router). The other SSOTD_* variables are passed on, except SSOTD_STATS, which this script sets
+# itself.
+set -e
+
+if [ $# -lt 2 ]; then
+  sed -n 4p "$0" | cut -c3-
+  exit 1
+fi
+GRAPH=$1
+PLANS=$2
+THREADS=${3:-1 2 4 8 16 32 64}
+REPETITIONS=${4:-3}
+ROUTER=${ROUTER:-./router}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+# run <parallel> <threads>: prints "<search ms> <visits> <rounds> <summed OT>" of the fastest run
+run() {
+  local best=""
+  for ((r = 0; r < REPETITIONS; r++)); do
+    rm -f "$WORK/stats.csv"
+    SSOTD_PARALLEL_SEARCH=$1 OMP_NUM_THREADS=$2 SSOTD_STATS="$WORK/stats.csv" \
+      SSOTD_STATS_FORMAT=csv "$ROUTER" "$GRAPH" "$PLANS" "$WORK/out.xml" > "$WORK/log.txt"
+    local rounds
+    rounds=$(awk '/^Parallel rounds:/ { s += $3 } END { print s + 0 }' "$WORK/log.txt")
+    local line
+    line=$(awk -F, -v rounds="$rounds" '
+      NR == 1 { for (i = 1; i <= NF; i++) col[$i] = i; next }
+      { us += $col["search_us"]; visits += $col["visits"]; ot += $col["ot"] }
+      END { printf "%.1f %d %d %d\n", us / 1000, visits, rounds, ot }' "$WORK/stats.csv")
+    if [ -z "$best" ] || awk -v a="${line%% *}" -v b="${best%% *}" 'BEGIN { exit !(a < b) }'; then
+      best=$line
+    fi
+  done
+  echo "$best"
+}
+
+printf "%-12s %12s %12s %10s %14s\n" threads "search ms" visits rounds "summed OT"
+read -r ms visits rounds ot <<< "$(run 0 1)"
+printf "%-12s %12s %12s %10s %14s\n" sequential "$ms" "$visits" - "$ot"
+for t in $THREADS; do
+  read -r ms visits rounds ot <<< "$(run 1 "$t")"
+  printf "%-12s %12s %12s %10s %14s\n" "$t" "$ms" "$visits" "$rounds" "$ot"
+done
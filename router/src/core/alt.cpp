@@ -0,0 +1,182 @@
+#include "core/alt.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/data.h"
+#include "core/globals.h"
+#include "core/graph.h"
+
+using namespace std;
+
+static constexpr char alt_magic[4] = {'A', 'L', 'T', '2'};
+
+static bool usable(int v) { return !adj[v].empty() || !adj_inv[v].empty(); }
+
+static int metric_index(metric m) { return m == metric::a ? 0 : 1; }
+
+void landmarks::select(size_t count, strategy s, unsigned seed) {
+  n = adj.size();
+  chosen.clear();
+  vector<int> candidates;
+  for (size_t v = 0; v < n; v++)
+    if (usable(v))
+      candidates.push_back(v);
+  count = min(count, candidates.size());
+  if (count == 0)
+    return;
+  // link weights are cached lazily, which must not happen concurrently below
+  for (auto& links : adj)
+    for (link* l : links) {
+      l->a();
+      l->b();
+    }
+
+  mt19937 gen(seed);
+  if (s == strategy::random) {
+    shuffle(candidates.begin(), candidates.end(), gen);
+    chosen.assign(candidates.begin(), candidates.begin() + count);
+  } else {
+    // each new landmark is the node farthest away (in b) from all landmarks chosen so far
+    vector<double> closest(n, HUGE_VAL), dist;
+    int next = candidates[uniform_int_distribution<size_t>(0, candidates.size() - 1)(gen)];
+    while (next >= 0 && chosen.size() < count) {
+      chosen.push_back(next);
+      one_to_all(next, forward_graph(), {{metric::b, &dist}});
+      double farthest = 0;
+      next = -1;
+      for (int v : candidates) {
+        closest[v] = min(closest[v], dist[v]);
+        if (closest[v] < HUGE_VAL && closest[v] > farthest) {
+          farthest = closest[v];
+          next = v;
+        }
+      }
+    }
+  }
+
+  size_t L = chosen.size();
+  for (int m = 0; m < 2; m++) {
+    from[m].assign(n * L, HUGE_VAL);
+    to[m].assign(n * L, HUGE_VAL);
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (size_t l = 0; l < L; l++) {
+    vector<double> from_a, from_b, to_a, to_b;
+    one_to_all(chosen[l], forward_graph(), {{metric::b, &from_b}, {metric::a, &from_a}});
+    one_to_all(chosen[l], backward_graph(), {{metric::b, &to_b}, {metric::a, &to_a}});
+    for (size_t v = 0; v < n; v++) {
+      from[0][v * L + l] = from_a[v];
+      from[1][v * L + l] = from_b[v];
+      to[0][v * L + l] = to_a[v];
+      to[1][v * L + l] = to_b[v];
+    }
+  }
+}
+
+double landmarks::lower_bound(metric m, int v, int w) const {
+  if (m == metric::taud || chosen.empty())
+    return 0.0;  // no tables for taud, it depends on the number of agents
+  int i = metric_index(m);
+  size_t L = chosen.size();
+  const double* from_v = &from[i][v * L];
+  const double* from_w = &from[i][w * L];
+  const double* to_v = &to[i][v * L];
+  const double* to_w = &to[i][w * L];
+  double bound = 0.0;
+  for (size_t l = 0; l < L; l++) {
+    // d(v, w) >= d(l, w) - d(l, v) and d(v, w) >= d(v, l) - d(w, l)
+    if (from_v[l] < HUGE_VAL && from_w[l] < HUGE_VAL)
+      bound = max(bound, from_w[l] - from_v[l]);
+    if (to_v[l] < HUGE_VAL && to_w[l] < HUGE_VAL)
+      bound = max(bound, to_v[l] - to_w[l]);
+  }
+  return bound;
+}
+
+void landmarks::fill_bounds(int anchor, bool to_anchor, metric m, vector<double>& bound) const {
+  bound.resize(n);
+#pragma omp parallel for schedule(static)
+  for (size_t v = 0; v < n; v++)
+    bound[v] = to_anchor ? lower_bound(m, v, anchor) : lower_bound(m, anchor, v);
+}
+
+void landmarks::save(const string& path, uint64_t fingerprint, size_t count, strategy s) const {
+  ofstream out(path, ios::binary);
+  uint64_t header[4] = {fingerprint, n, count, chosen.size()};
+  int32_t strat = static_cast<int32_t>(s);
+  out.write(alt_magic, sizeof(alt_magic));
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(&strat), sizeof(strat));
+  for (int32_t v : chosen)
+    out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+  for (int m = 0; m < 2; m++) {
+    out.write(reinterpret_cast<const char*>(from[m].data()), from[m].size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(to[m].data()), to[m].size() * sizeof(double));
+  }
+}
+
+bool landmarks::load(const string& path, uint64_t fingerprint, size_t count, strategy s) {
+  ifstream in(path, ios::binary);
+  char magic[4];
+  uint64_t header[4];
+  int32_t strat;
+  if (!in.read(magic, sizeof(magic)) || memcmp(magic, alt_magic, sizeof(magic)) != 0)
+    return false;
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+      !in.read(reinterpret_cast<char*>(&strat), sizeof(strat)))
+    return false;
+  // select may choose fewer landmarks than requested (no more than the usable nodes, and the
+  // farthest strategy stops once no node is left to reach), so the request is stored as well
+  if (header[0] != fingerprint || header[1] != adj.size() || header[2] != count ||
+      header[3] > count || strat != static_cast<int32_t>(s))
+    return false;
+  n = header[1];
+  chosen.resize(header[3]);
+  for (int& v : chosen) {
+    int32_t id;
+    in.read(reinterpret_cast<char*>(&id), sizeof(id));
+    v = id;
+  }
+  for (int m = 0; m < 2; m++) {
+    from[m].resize(n * chosen.size());
+    to[m].resize(n * chosen.size());
+    in.read(reinterpret_cast<char*>(from[m].data()), from[m].size() * sizeof(double));
+    in.read(reinterpret_cast<char*>(to[m].data()), to[m].size() * sizeof(double));
+  }
+  if (!in) {
+    chosen.clear();
+    return false;
+  }
+  return true;
+}
+
+uint64_t graph_fingerprint() {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix = [&hash](const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  };
+  uint64_t size = adj.size();
+  mix(&size, sizeof(size));
+  for (auto& links : adj)
+    for (link* l : links) {
+      double a = l->a(), b = l->b();
+      mix(&l->id, sizeof(l->id));
+      mix(&l->from, sizeof(l->from));
+      mix(&l->to, sizeof(l->to));
+      mix(&a, sizeof(a));
+      mix(&b, sizeof(b));
+    }
+  return hash;
+}
@@ -0,0 +1,479 @@
+#include "core/ch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/data.h"
+#include "core/globals.h"
+
+using namespace std;
+
+static constexpr char cch_magic[4] = {'C', 'C', 'H', '1'};
+static constexpr size_t dissection_leaf = 16;
+
+namespace {
+
+// Nested dissection by coordinate bisection: a cell is split at the median of its longer side,
+// the nodes of the smaller side that have a neighbour on the other side become the separator.
+// Both halves are ordered first (recursively), the separator gets the highest ranks.
+struct dissection {
+  const vector<vector<int>>& nbrs;
+  const vector<double>& x;
+  const vector<double>& y;
+  vector<int> mark;
+  int stamp = 0;
+  vector<int> order;
+
+  dissection(const vector<vector<int>>& _nbrs, const vector<double>& _x, const vector<double>& _y)
+      : nbrs(_nbrs), x(_x), y(_y), mark(_nbrs.size(), 0) {}
+
+  vector<int> boundary(const vector<int>& side, const vector<int>& other,
+                       vector<int>* inner = nullptr) {
+    stamp++;
+    for (int v : other)
+      mark[v] = stamp;
+    vector<int> result;
+    for (int v : side) {
+      bool cut = any_of(nbrs[v].begin(), nbrs[v].end(), [&](int u) { return mark[u] == stamp; });
+      if (cut)
+        result.push_back(v);
+      else if (inner)
+        inner->push_back(v);
+    }
+    return result;
+  }
+
+  void run(vector<int> cell) {
+    if (cell.size() <= dissection_leaf) {
+      order.insert(order.end(), cell.begin(), cell.end());
+      return;
+    }
+    auto [min_x, max_x] = minmax_element(cell.begin(), cell.end(),
+                                         [&](int a, int b) { return x[a] < x[b]; });
+    auto [min_y, max_y] = minmax_element(cell.begin(), cell.end(),
+                                         [&](int a, int b) { return y[a] < y[b]; });
+    bool by_x = x[*max_x] - x[*min_x] >= y[*max_y] - y[*min_y];
+    size_t mid = cell.size() / 2;
+    nth_element(cell.begin(), cell.begin() + mid, cell.end(),
+                [&](int a, int b) { return by_x ? x[a] < x[b] : y[a] < y[b]; });
+    vector<int> left(cell.begin(), cell.begin() + mid), right(cell.begin() + mid, cell.end());
+    cell = vector<int>();
+
+    vector<int> left_inner, right_inner;
+    auto left_cut = boundary(left, right, &left_inner);
+    auto right_cut = boundary(right, left, &right_inner);
+    if (left_cut.size() <= right_cut.size()) {
+      run(move(left_inner));
+      run(move(right));
+      order.insert(order.end(), left_cut.begin(), left_cut.end());
+    } else {
+      run(move(left));
+      run(move(right_inner));
+      order.insert(order.end(), right_cut.begin(), right_cut.end());
+    }
+  }
+};
+
+double coordinate(node* n, bool x) {
+  if (!n)
+    return 0.0;
+  return atof(x ? n->x : n->y);
+}
+
+}  // namespace
+
+void cch::build() {
+  size_t n = adj.size();
+  vector<vector<int>> nbrs(n);
+  for (size_t v = 0; v < n; v++) {
+    for (link* l : adj[v]) {
+      if (l->to == static_cast<int>(v))
+        continue;
+      nbrs[v].push_back(l->to);
+      nbrs[l->to].push_back(v);
+    }
+  }
+  for (auto& list : nbrs) {
+    sort(list.begin(), list.end());
+    list.erase(unique(list.begin(), list.end()), list.end());
+  }
+  vector<double> x(n), y(n);
+  for (size_t v = 0; v < n; v++) {
+    x[v] = coordinate(v < nodes.size() ? nodes[v] : nullptr, true);
+    y[v] = coordinate(v < nodes.size() ? nodes[v] : nullptr, false);
+  }
+
+  dissection nd(nbrs, x, y);
+  vector<int> all(n);
+  for (size_t v = 0; v < n; v++)
+    all[v] = v;
+  nd.run(move(all));
+  node_at = move(nd.order);
+  rank.assign(n, -1);
+  for (size_t r = 0; r < n; r++)
+    rank[node_at[r]] = r;
+
+  // contraction: the upper neighbours of a node are passed on to its lowest upper neighbour
+  // (its parent in the elimination tree), which yields the fill-in of contracting in rank order
+  vector<vector<int>> upper(n);
+  for (size_t v = 0; v < n; v++)
+    for (int u : nbrs[v])
+      if (rank[u] > rank[v])
+        upper[rank[v]].push_back(rank[u]);
+  nbrs = vector<vector<int>>();
+  first_up.assign(n + 1, 0);
+  up_head.clear();
+  for (size_t r = 0; r < n; r++) {
+    auto& heads = upper[r];
+    sort(heads.begin(), heads.end());
+    heads.erase(unique(heads.begin(), heads.end()), heads.end());
+    if (!heads.empty())
+      upper[heads[0]].insert(upper[heads[0]].end(), heads.begin() + 1, heads.end());
+    first_up[r] = up_head.size();
+    up_head.insert(up_head.end(), heads.begin(), heads.end());
+    heads = vector<int>();
+  }
+  first_up[n] = up_head.size();
+  finish();
+}
+
+void cch::finish() {
+  size_t n = rank.size();
+  node_at.assign(n, 0);
+  for (size_t v = 0; v < n; v++)
+    node_at[rank[v]] = v;
+  parent.assign(n, -1);
+  arc_tail.assign(up_head.size(), 0);
+  first_down.assign(n + 1, 0);
+  for (size_t r = 0; r < n; r++) {
+    if (first_up[r] < first_up[r + 1])
+      parent[r] = up_head[first_up[r]];
+    for (int a = first_up[r]; a < first_up[r + 1]; a++) {
+      arc_tail[a] = r;
+      first_down[up_head[a] + 1]++;
+    }
+  }
+  for (size_t r = 0; r < n; r++)
+    first_down[r + 1] += first_down[r];
+  down_tail.assign(up_head.size(), 0);
+  down_arc.assign(up_head.size(), 0);
+  vector<int> next(first_down.begin(), first_down.end() - 1);
+  for (size_t a = 0; a < up_head.size(); a++) {
+    int slot = next[up_head[a]]++;
+    down_tail[slot] = arc_tail[a];
+    down_arc[slot] = a;
+  }
+  vector<int> height(n, 0);
+  int levels = n > 0 ? 1 : 0;
+  for (size_t r = 0; r < n; r++) {
+    if (parent[r] >= 0)
+      height[parent[r]] = max(height[parent[r]], height[r] + 1);
+    levels = max(levels, height[r] + 1);
+  }
+  level_start.assign(levels + 1, 0);
+  for (size_t r = 0; r < n; r++)
+    level_start[height[r] + 1]++;
+  for (int l = 0; l < levels; l++)
+    level_start[l + 1] += level_start[l];
+  by_level.assign(n, 0);
+  next.assign(level_start.begin(), level_start.end() - 1);
+  for (size_t r = 0; r < n; r++)
+    by_level[next[height[r]]++] = r;
+
+  links_by_id.clear();
+  for (auto& links : adj)
+    for (link* l : links)
+      links_by_id[l->id] = l;
+}
+
+int cch::find_arc(int lower, int upper) const {
+  auto begin = up_head.begin() + first_up[lower], end = up_head.begin() + first_up[lower + 1];
+  auto it = lower_bound(begin, end, upper);
+  return it != end && *it == upper ? it - up_head.begin() : -1;
+}
+
+void cch::save(const string& path, uint64_t fingerprint) const {
+  ofstream out(path, ios::binary);
+  uint64_t header[3] = {fingerprint, rank.size(), up_head.size()};
+  out.write(cch_magic, sizeof(cch_magic));
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(rank.data()), rank.size() * sizeof(int));
+  out.write(reinterpret_cast<const char*>(first_up.data()), first_up.size() * sizeof(int));
+  out.write(reinterpret_cast<const char*>(up_head.data()), up_head.size() * sizeof(int));
+}
+
+bool cch::load(const string& path, uint64_t fingerprint) {
+  ifstream in(path, ios::binary);
+  char magic[4];
+  uint64_t header[3];
+  if (!in.read(magic, sizeof(magic)) || memcmp(magic, cch_magic, sizeof(magic)) != 0)
+    return false;
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != fingerprint ||
+      header[1] != adj.size())
+    return false;
+  rank.resize(header[1]);
+  first_up.resize(header[1] + 1);
+  up_head.resize(header[2]);
+  in.read(reinterpret_cast<char*>(rank.data()), rank.size() * sizeof(int));
+  in.read(reinterpret_cast<char*>(first_up.data()), first_up.size() * sizeof(int));
+  in.read(reinterpret_cast<char*>(up_head.data()), up_head.size() * sizeof(int));
+  if (!in) {
+    rank.clear();
+    return false;
+  }
+  finish();
+  return true;
+}
+
+cch_metric::cch_metric(const cch& hierarchy, function<double(link*)> _weight)
+    : h(&hierarchy), weight(move(_weight)) {
+  customize();
+}
+
+void cch_metric::customize() {
+  size_t arcs = h->arcs();
+  up.assign(arcs, HUGE_VAL);
+  down.assign(arcs, HUGE_VAL);
+  up_mid.assign(arcs, -1);
+  down_mid.assign(arcs, -1);
+  up_link.assign(arcs, nullptr);
+  down_link.assign(arcs, nullptr);
+  for (auto& links : adj) {
+    for (link* l : links) {
+      int from = h->rank[l->from], to = h->rank[l->to];
+      if (from == to)
+        continue;
+      double w = weight(l);
+      if (from < to) {
+        int arc = h->find_arc(from, to);
+        if (w < up[arc]) {
+          up[arc] = w;
+          up_link[arc] = l;
+        }
+      } else {
+        int arc = h->find_arc(to, from);
+        if (w < down[arc]) {
+          down[arc] = w;
+          down_link[arc] = l;
+        }
+      }
+    }
+  }
+  // lower triangles: the arcs from a lower neighbour u of v to v and to w > v are a path
+  // v -> u -> w (and back) for the arc (v, w). Every node only writes its own upward arcs and
+  // reads the ones of its lower neighbours, which are in lower levels.
+  for (size_t level = 0; level + 1 < h->level_start.size(); level++) {
+#pragma omp parallel for schedule(dynamic, 64)
+    for (int i = h->level_start[level]; i < h->level_start[level + 1]; i++) {
+      int v = h->by_level[i];
+      for (int k = h->first_down[v]; k < h->first_down[v + 1]; k++) {
+        int u = h->down_tail[k], arc = h->first_up[v];
+        for (int j = h->down_arc[k] + 1; j < h->first_up[u + 1]; j++) {
+          while (h->up_head[arc] < h->up_head[j])
+            arc++;
+          relax_triangle(u, h->down_arc[k], j, arc);
+        }
+      }
+    }
+  }
+}
+
+bool cch_metric::relax_triangle(int lower, int arc_lower_tail, int arc_lower_head, int arc) {
+  bool changed = false;
+  double via = down[arc_lower_tail] + up[arc_lower_head];
+  if (via < up[arc]) {
+    up[arc] = via;
+    up_mid[arc] = lower;
+    changed = true;
+  }
+  via = down[arc_lower_head] + up[arc_lower_tail];
+  if (via < down[arc]) {
+    down[arc] = via;
+    down_mid[arc] = lower;
+    changed = true;
+  }
+  return changed;
+}
+
+bool cch_metric::initial_weights(int arc) {
+  double old_up = up[arc], old_down = down[arc];
+  int from = h->node_at[h->arc_tail[arc]], to = h->node_at[h->up_head[arc]];
+  up[arc] = down[arc] = HUGE_VAL;
+  up_mid[arc] = down_mid[arc] = -1;
+  up_link[arc] = down_link[arc] = nullptr;
+  auto is_excluded = [this](link* l) {
+    auto it = excluded.find(l->id);
+    return it != excluded.end() && it->second;
+  };
+  for (link* l : adj[from]) {
+    if (l->to == to && !is_excluded(l) && weight(l) < up[arc]) {
+      up[arc] = weight(l);
+      up_link[arc] = l;
+    }
+  }
+  for (link* l : adj[to]) {
+    if (l->to == from && !is_excluded(l) && weight(l) < down[arc]) {
+      down[arc] = weight(l);
+      down_link[arc] = l;
+    }
+  }
+  return up[arc] != old_up || down[arc] != old_down;
+}
+
+// Excluding links only makes arcs more expensive. The arcs of the excluded links are recomputed
+// from scratch (original links and all lower triangles), and whenever an arc (x, y) changes, the
+// arcs (y, z) of the triangles it is the lower side of are recomputed as well, in rank order.
+cch_metric cch_metric::without(const unordered_map<int, bool>& links) const {
+  cch_metric metric(*this);
+  set<pair<int, int>> dirty;  // (rank of the lower end, arc)
+  for (auto& [id, is_excluded] : links) {
+    auto it = h->links_by_id.find(id);
+    if (!is_excluded || it == h->links_by_id.end())
+      continue;
+    metric.excluded[id] = true;
+    int from = h->rank[it->second->from], to = h->rank[it->second->to];
+    if (from == to)
+      continue;
+    int arc = h->find_arc(min(from, to), max(from, to));
+    dirty.insert({h->arc_tail[arc], arc});
+  }
+  while (!dirty.empty()) {
+    int arc = dirty.begin()->second;
+    dirty.erase(dirty.begin());
+    int x = h->arc_tail[arc], y = h->up_head[arc];
+    double old_up = metric.up[arc], old_down = metric.down[arc];
+    metric.initial_weights(arc);
+    for (int k = h->first_down[x]; k < h->first_down[x + 1]; k++) {
+      int lower_arc_head = h->find_arc(h->down_tail[k], y);
+      if (lower_arc_head >= 0)
+        metric.relax_triangle(h->down_tail[k], h->down_arc[k], lower_arc_head, arc);
+    }
+    if (metric.up[arc] == old_up && metric.down[arc] == old_down)
+      continue;
+    for (int a = h->first_up[x]; a < h->first_up[x + 1]; a++) {
+      int z = h->up_head[a];
+      if (z == y)
+        continue;
+      int affected = h->find_arc(min(y, z), max(y, z));
+      dirty.insert({min(y, z), affected});
+    }
+  }
+  return metric;
+}
+
+void cch_metric::unpack(int arc, bool upward, vector<link*>& links) const {
+  int mid = upward ? up_mid[arc] : down_mid[arc];
+  if (mid < 0) {
+    links.push_back(upward ? up_link[arc] : down_link[arc]);
+    return;
+  }
+  int to_tail = h->find_arc(mid, h->arc_tail[arc]);
+  int to_head = h->find_arc(mid, h->up_head[arc]);
+  if (upward) {  // tail -> mid -> head
+    unpack(to_tail, false, links);
+    unpack(to_head, true, links);
+  } else {  // head -> mid -> tail
+    unpack(to_head, false, links);
+    unpack(to_tail, true, links);
+  }
+}
+
+// Elimination tree query: everything the upward search from a node can reach lies on its path to
+// the root of the elimination tree, so both searches just walk up the tree.
+shared_ptr<route> cch_metric::query(int from, int to) const {
+  size_t n = h->size();
+  if (forward_dist.size() != n) {
+    forward_dist.assign(n, HUGE_VAL);
+    backward_dist.assign(n, HUGE_VAL);
+    forward_pred.assign(n, -1);
+    backward_pred.assign(n, -1);
+  }
+  int s = h->rank[from], t = h->rank[to];
+  forward_dist[s] = 0.0;
+  for (int r = s; r != -1; r = h->parent[r]) {
+    if (forward_dist[r] == HUGE_VAL)
+      continue;
+    for (int a = h->first_up[r]; a < h->first_up[r + 1]; a++) {
+      double dist = forward_dist[r] + up[a];
+      if (dist < forward_dist[h->up_head[a]]) {
+        forward_dist[h->up_head[a]] = dist;
+        forward_pred[h->up_head[a]] = a;
+      }
+    }
+  }
+  backward_dist[t] = 0.0;
+  for (int r = t; r != -1; r = h->parent[r]) {
+    if (backward_dist[r] == HUGE_VAL)
+      continue;
+    for (int a = h->first_up[r]; a < h->first_up[r + 1]; a++) {
+      double dist = backward_dist[r] + down[a];
+      if (dist < backward_dist[h->up_head[a]]) {
+        backward_dist[h->up_head[a]] = dist;
+        backward_pred[h->up_head[a]] = a;
+      }
+    }
+  }
+  double best = HUGE_VAL;
+  int meet = -1;
+  for (int r = s; r != -1; r = h->parent[r]) {
+    if (forward_dist[r] + backward_dist[r] < best) {
+      best = forward_dist[r] + backward_dist[r];
+      meet = r;
+    }
+  }
+
+  shared_ptr<route> result;
+  if (meet >= 0) {
+    vector<int> forward_arcs;
+    for (int r = meet; r != s; r = h->arc_tail[forward_pred[r]])
+      forward_arcs.push_back(forward_pred[r]);
+    vector<link*> links;
+    for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); it++)
+      unpack(*it, true, links);
+    for (int r = meet; r != t; r = h->arc_tail[backward_pred[r]])
+      unpack(backward_pred[r], false, links);
+    result = make_shared<route>(links);
+  }
+  for (int r = s; r != -1; r = h->parent[r]) {
+    forward_dist[r] = HUGE_VAL;
+    forward_pred[r] = -1;
+  }
+  for (int r = t; r != -1; r = h->parent[r]) {
+    backward_dist[r] = HUGE_VAL;
+    backward_pred[r] = -1;
+  }
+  return result;
+}
+
+// PHAST: an upward search from source along the elimination tree, followed by one sweep over all
+// nodes from the highest rank downwards.
+void cch_metric::one_to_all(int source, bool forward, vector<double>& dist) const {
+  size_t n = h->size();
+  vector<double> by_rank(n, HUGE_VAL);
+  int s = h->rank[source];
+  by_rank[s] = 0.0;
+  const vector<double>& upward = forward ? up : down;
+  const vector<double>& downward = forward ? down : up;
+  for (int r = s; r != -1; r = h->parent[r]) {
+    if (by_rank[r] == HUGE_VAL)
+      continue;
+    for (int a = h->first_up[r]; a < h->first_up[r + 1]; a++)
+      by_rank[h->up_head[a]] = min(by_rank[h->up_head[a]], by_rank[r] + upward[a]);
+  }
+  for (int r = n - 1; r >= 0; r--)
+    for (int a = h->first_up[r]; a < h->first_up[r + 1]; a++)
+      by_rank[r] = min(by_rank[r], by_rank[h->up_head[a]] + downward[a]);
+  dist.resize(n);
+  for (size_t r = 0; r < n; r++)
+    dist[h->node_at[r]] = by_rank[r];
+}
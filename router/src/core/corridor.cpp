@@ -0,0 +1,155 @@
+#include "core/corridor.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+#include "core/globals.h"
+#include "core/graph.h"
+
+using namespace std;
+
+corridor od_corridor;
+
+void parse_corridor_env(const string& prefix, const string& default_kind, double default_slack,
+                        string& kind, double& slack) {
+  string kind_name = prefix + "_CORRIDOR";
+  char* kind_env = getenv(kind_name.c_str());
+  if (kind_env == nullptr) {
+    cout << "You may specify the env variable " << kind_name << " (none, distance or ellipse)"
+         << endl;
+    kind = default_kind;
+  } else {
+    kind = string(kind_env);
+  }
+  if (kind != "none" && kind != "distance" && kind != "ellipse") {
+    cerr << "Unknown " << kind_name << " " << kind << ", using " << default_kind << endl;
+    kind = default_kind;
+  }
+
+  string slack_name = prefix + "_CORRIDOR_SLACK";
+  char* slack_env = getenv(slack_name.c_str());
+  if (slack_env == nullptr) {
+    cout << "You may specify the env variable " << slack_name << endl;
+    slack = default_slack;
+  } else {
+    slack = strtod(slack_env, nullptr);
+  }
+  if (slack < 0) {
+    cerr << slack_name << " has to be non-negative, using " << default_slack << endl;
+    slack = default_slack;
+  }
+}
+
+static bool coordinates(int v, double& x, double& y) {
+  if (v >= static_cast<int>(nodes.size()) || !nodes[v])
+    return false;
+  x = atof(nodes[v]->x);
+  y = atof(nodes[v]->y);
+  return true;
+}
+
+bool corridor::enter(int from, int to, const string& kind, double slack) {
+  leave();
+  if (kind == "none")
+    return false;
+  vector<bool> keep(adj.size(), false);
+  if (kind == "distance") {
+    vector<double> from_origin, to_destination;
+    one_to_all(from, forward_graph(), {{metric::b, &from_origin}});
+    one_to_all(to, backward_graph(), {{metric::b, &to_destination}});
+    double limit = (1 + slack) * from_origin[to];
+    for (size_t v = 0; v < adj.size(); v++)
+      keep[v] = from_origin[v] + to_destination[v] <= limit;
+  } else {
+    double fx, fy, tx, ty, x, y;
+    if (!coordinates(from, fx, fy) || !coordinates(to, tx, ty)) {
+      cout << "No coordinates for " << from << " or " << to << ", routing on the full graph"
+           << endl;
+      return false;
+    }
+    double limit = (1 + slack) * hypot(tx - fx, ty - fy);
+    for (size_t v = 0; v < adj.size(); v++)
+      keep[v] = coordinates(v, x, y) && hypot(x - fx, y - fy) + hypot(x - tx, y - ty) <= limit;
+  }
+  keep[from] = keep[to] = true;
+  restrict_to(keep);
+
+  vector<double> reachable;
+  one_to_all(local(from), forward_graph(), {{metric::b, &reachable}});
+  if (reachable[local(to)] == HUGE_VAL) {
+    leave();
+    cout << "The " << kind << " corridor disconnects " << from << " and " << to
+         << ", routing on the full graph" << endl;
+    return false;
+  }
+  cout << "Routing in a " << kind << " corridor of " << size() << " nodes and "
+       << local_links.size() << " links" << endl;
+  return true;
+}
+
+void corridor::restrict_to(const vector<bool>& keep) {
+  local_of.assign(adj.size(), -1);
+  global_of.clear();
+  for (size_t v = 0; v < adj.size(); v++) {
+    if (keep[v]) {
+      local_of[v] = global_of.size();
+      global_of.push_back(v);
+    }
+  }
+  // the copies have to be complete before pointers to them are taken
+  for (int v : global_of) {
+    for (link* l : adj[v]) {
+      if (local_of[l->to] < 0)
+        continue;
+      local_links.push_back(*l);
+      local_links.back().from = local_of[v];
+      local_links.back().to = local_of[l->to];
+      original.push_back(l);
+    }
+  }
+  local_adj.assign(global_of.size(), {});
+  local_adj_inv.assign(global_of.size(), {});
+  local_nodes.resize(global_of.size());
+  for (size_t v = 0; v < global_of.size(); v++)
+    local_nodes[v] = global_of[v] < static_cast<int>(nodes.size()) ? nodes[global_of[v]] : nullptr;
+  for (link& l : local_links) {
+    local_adj[l.from].push_back(&l);
+    local_adj_inv[l.to].push_back(&l);
+  }
+  swap_graph();
+  entered = true;
+}
+
+void corridor::swap_graph() {
+  swap(adj, local_adj);
+  swap(adj_inv, local_adj_inv);
+  swap(nodes, local_nodes);
+}
+
+void corridor::leave() {
+  if (!entered)
+    return;
+  swap_graph();
+  entered = false;
+  local_adj.clear();
+  local_adj_inv.clear();
+  local_nodes.clear();
+  local_of.clear();
+  global_of.clear();
+  local_links.clear();
+  original.clear();
+}
+
+route corridor::to_global(const route& r) const {
+  if (!entered)
+    return r;
+  vector<link*> links;
+  for (link* l : r.links)
+    links.push_back(original[l - local_links.data()]);
+  return route(links);
+}
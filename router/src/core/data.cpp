@@ -252,6 +252,7 @@ ParetoElement::ParetoElement(shared_ptr<ParetoElement> par) {  // recursive memo
   if (par->parent != nullptr)
     parent = make_shared<ParetoElement>(par->parent);
   myLink = par->myLink;
+  _cover = par->_cover;
   _a = par->a();
   _b = par->b();
   _taud = par->shared_taud();
@@ -268,6 +269,14 @@ ParetoElement::ParetoElement(double a, double b, double taud, double sa, double
   _shared_b = sb;
   _shared_taud = staud;
 }
+ParetoElement::ParetoElement(shared_ptr<ParetoElement> par, link* l, double a, double b,
+                             double taud, double sa, double sb, double staud, double cover)
+    : ParetoElement(a, b, taud, sa, sb, staud) {
+  parent = par;
+  myLink = l;
+  _cover = cover;
+}
+
 double ParetoElement::a() const { return _a; }
 double ParetoElement::b() const { return _b; }
 double ParetoElement::taud() const { return _taud; }
@@ -276,6 +285,21 @@ double ParetoElement::shared_b() const { return _shared_b; }
 double ParetoElement::shared_taud() const { return _shared_taud; }
 bool ParetoElement::operator<(const ParetoElement& other) const { return k() < other.k(); }
 
+void ParetoElement::cover(double factor) { _cover = std::max(_cover, factor); }
+
+double ParetoElement::approx() const {
+  // extensions of a prefix inherit every path the prefix stands in for, even if the prefix was
+  // only updated after they had been created
+  double factor = _cover;
+  for (auto p = parent.get(); p != nullptr; p = p->parent.get())
+    factor = std::max(factor, p->_cover);
+  return factor;
+}
+
+double ParetoElement::own_cover() const { return _cover; }
+
+const shared_ptr<ParetoElement>& ParetoElement::get_parent() const { return parent; }
+
 unique_ptr<vector<link*>> ParetoElement::collectLinks() {
   if (parent != nullptr) {
     auto links = parent->collectLinks();
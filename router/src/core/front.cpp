@@ -0,0 +1,142 @@
+#include "core/front.h"
+
+#include <cstdint>
+#include <utility>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// the new label and the dominance factor it is tested with
+struct probe {
+  double b, taud, shared_a;
+  double f;  // 1 + eps
+  bool strong;
+};
+
+// Scans the stored labels from..n-1. Returns the first one that dominates the probe (n if none)
+// and marks those the probe dominates in dominated (only valid if there is no such label).
+size_t scan_scalar(const double* b, const double* t, const double* s, size_t from, size_t n,
+                   const probe& p, uint8_t* dominated) {
+  for (size_t i = from; i < n; i++) {
+    if (b[i] <= p.f * p.b && t[i] <= p.f * p.taud && (!p.strong || s[i] <= p.f * p.shared_a))
+      return i;
+    dominated[i] =
+        p.b <= p.f * b[i] && p.taud <= p.f * t[i] && (!p.strong || p.shared_a <= p.f * s[i]);
+  }
+  return n;
+}
+
+#if defined(__AVX512F__)
+size_t scan(const double* b, const double* t, const double* s, size_t n, const probe& p,
+            uint8_t* dominated) {
+  const __m512d f = _mm512_set1_pd(p.f);
+  const __m512d nb = _mm512_set1_pd(p.b), nt = _mm512_set1_pd(p.taud),
+                ns = _mm512_set1_pd(p.shared_a);
+  const __m512d fb = _mm512_set1_pd(p.f * p.b), ft = _mm512_set1_pd(p.f * p.taud),
+                fs = _mm512_set1_pd(p.f * p.shared_a);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d vb = _mm512_loadu_pd(b + i), vt = _mm512_loadu_pd(t + i);
+    __mmask8 dom = _mm512_cmp_pd_mask(vb, fb, _CMP_LE_OQ) & _mm512_cmp_pd_mask(vt, ft, _CMP_LE_OQ);
+    __mmask8 rem = _mm512_cmp_pd_mask(nb, _mm512_mul_pd(f, vb), _CMP_LE_OQ) &
+                   _mm512_cmp_pd_mask(nt, _mm512_mul_pd(f, vt), _CMP_LE_OQ);
+    if (p.strong) {
+      __m512d vs = _mm512_loadu_pd(s + i);
+      dom &= _mm512_cmp_pd_mask(vs, fs, _CMP_LE_OQ);
+      rem &= _mm512_cmp_pd_mask(ns, _mm512_mul_pd(f, vs), _CMP_LE_OQ);
+    }
+    if (dom)
+      return i + __builtin_ctz(dom);
+    for (int j = 0; j < 8; j++)
+      dominated[i + j] = (rem >> j) & 1;
+  }
+  return scan_scalar(b, t, s, i, n, p, dominated);
+}
+#elif defined(__AVX2__)
+size_t scan(const double* b, const double* t, const double* s, size_t n, const probe& p,
+            uint8_t* dominated) {
+  const __m256d f = _mm256_set1_pd(p.f);
+  const __m256d nb = _mm256_set1_pd(p.b), nt = _mm256_set1_pd(p.taud),
+                ns = _mm256_set1_pd(p.shared_a);
+  const __m256d fb = _mm256_set1_pd(p.f * p.b), ft = _mm256_set1_pd(p.f * p.taud),
+                fs = _mm256_set1_pd(p.f * p.shared_a);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d vb = _mm256_loadu_pd(b + i), vt = _mm256_loadu_pd(t + i);
+    __m256d dom =
+        _mm256_and_pd(_mm256_cmp_pd(vb, fb, _CMP_LE_OQ), _mm256_cmp_pd(vt, ft, _CMP_LE_OQ));
+    __m256d rem = _mm256_and_pd(_mm256_cmp_pd(nb, _mm256_mul_pd(f, vb), _CMP_LE_OQ),
+                                _mm256_cmp_pd(nt, _mm256_mul_pd(f, vt), _CMP_LE_OQ));
+    if (p.strong) {
+      __m256d vs = _mm256_loadu_pd(s + i);
+      dom = _mm256_and_pd(dom, _mm256_cmp_pd(vs, fs, _CMP_LE_OQ));
+      rem = _mm256_and_pd(rem, _mm256_cmp_pd(ns, _mm256_mul_pd(f, vs), _CMP_LE_OQ));
+    }
+    if (int dom_mask = _mm256_movemask_pd(dom))
+      return i + __builtin_ctz(dom_mask);
+    int rem_mask = _mm256_movemask_pd(rem);
+    for (int j = 0; j < 4; j++)
+      dominated[i + j] = (rem_mask >> j) & 1;
+  }
+  return scan_scalar(b, t, s, i, n, p, dominated);
+}
+#else
+size_t scan(const double* b, const double* t, const double* s, size_t n, const probe& p,
+            uint8_t* dominated) {
+  return scan_scalar(b, t, s, 0, n, p, dominated);
+}
+#endif
+
+thread_local vector<uint8_t> dominated;  // removal mask of the current insert
+
+}  // namespace
+
+void label_front::push_back(shared_ptr<ParetoElement> par) {
+  b.push_back(par->b());
+  taud.push_back(par->taud());
+  shared_a.push_back(par->shared_a());
+  labels.push_back(move(par));
+}
+
+void label_front::swap(label_front& other) {
+  labels.swap(other.labels);
+  b.swap(other.b);
+  taud.swap(other.taud);
+  shared_a.swap(other.shared_a);
+}
+
+shared_ptr<ParetoElement> label_front::insert(shared_ptr<ParetoElement>& par, bool strong,
+                                              double eps, labels_type* removed) {
+  probe p{par->b(), par->taud(), par->shared_a(), 1 + eps, strong};
+  size_t n = labels.size();
+  dominated.resize(n);
+  size_t dominator = scan(b.data(), taud.data(), shared_a.data(), n, p, dominated.data());
+  if (dominator < n)
+    return labels[dominator];
+
+  size_t kept = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (dominated[i]) {
+      if (removed)
+        removed->push_back(move(labels[i]));
+      continue;
+    }
+    if (kept != i) {
+      labels[kept] = move(labels[i]);
+      b[kept] = b[i];
+      taud[kept] = taud[i];
+      shared_a[kept] = shared_a[i];
+    }
+    kept++;
+  }
+  labels.resize(kept);
+  b.resize(kept);
+  taud.resize(kept);
+  shared_a.resize(kept);
+  push_back(par);
+  return nullptr;
+}
@@ -0,0 +1,64 @@
+#include "core/geometric.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "core/corridor.h"
+#include "core/data.h"
+#include "core/globals.h"
+#include "core/graph.h"
+
+using namespace std;
+
+void geometric_bounds::prepare() {
+  od_corridor.outside([this] {
+    size_t n = adj.size();
+    x.assign(n, 0.0);
+    y.assign(n, 0.0);
+    bool located = true;
+    for (size_t v = 0; v < n; v++) {
+      if (v >= nodes.size() || !nodes[v]) {
+        located = located && adj[v].empty() && adj_inv[v].empty();
+        continue;
+      }
+      x[v] = atof(nodes[v]->x);
+      y[v] = atof(nodes[v]->y);
+    }
+    // a path through a node without coordinates has no straight-line length to compare with
+    if (!located) {
+      cout << "Not all nodes have coordinates, the geometric bounds are 0" << endl;
+      per_distance[0] = per_distance[1] = 0.0;
+      prepared = true;
+      return;
+    }
+    per_distance[0] = per_distance[1] = HUGE_VAL;
+    for (auto& links : adj) {
+      for (link* l : links) {
+        double d = hypot(x[l->to] - x[l->from], y[l->to] - y[l->from]);
+        if (d <= 0)
+          continue;
+        per_distance[0] = min(per_distance[0], l->a() / d);
+        per_distance[1] = min(per_distance[1], l->b() / d);
+      }
+    }
+    // a little below the minimum, so that rounding never makes a bound inadmissible
+    for (double& f : per_distance)
+      f = f == HUGE_VAL ? 0.0 : f * (1 - 1e-9);
+    cout << "Geometric bounds: a >= " << per_distance[0] << ", b >= " << per_distance[1]
+         << " per unit of distance" << endl;
+    prepared = true;
+  });
+}
+
+void geometric_bounds::fill_bounds(int anchor, metric m, vector<double>& bound) const {
+  double f = per_distance[m == metric::a ? 0 : 1];
+  int a = od_corridor.global(anchor);
+  bound.resize(adj.size());
+  for (size_t v = 0; v < adj.size(); v++) {
+    int g = od_corridor.global(v);
+    bound[v] = f * hypot(x[g] - x[a], y[g] - y[a]);
+  }
+}
@@ -0,0 +1,102 @@
+#include "core/graph.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+#include "core/globals.h"
+
+using namespace std;
+
+static constexpr size_t max_metrics = 3;
+
+graph_view forward_graph() { return {adj, true}; }
+
+graph_view backward_graph() { return {adj_inv, false}; }
+
+static double weight(link* l, metric m) {
+  switch (m) {
+    case metric::a:
+      return l->a();
+    case metric::b:
+      return l->b();
+    case metric::taud:
+      return l->taud();
+  }
+  return HUGE_VAL;
+}
+
+// The queue is ordered by the first metric, so that one is label-setting as in a plain Dijkstra.
+// The other metrics are label-correcting: whenever one of them improves at a node, the node is
+// marked dirty for that metric and (re-)queued, and the next scan of the node only relaxes its
+// dirty metrics. As the metrics are strongly correlated, this hardly ever rescans a node.
+void many_to_all(const vector<pair<int, vector<double>>>& sources, const graph_view& graph,
+                 const vector<pair<metric, vector<double>*>>& targets,
+                 const unordered_map<int, bool>& inactive) {
+  size_t metrics = min(targets.size(), max_metrics);
+  if (metrics == 0)
+    return;
+  array<vector<double>*, max_metrics> dist;
+  array<metric, max_metrics> kind;
+  for (size_t m = 0; m < metrics; m++) {
+    kind[m] = targets[m].first;
+    dist[m] = targets[m].second;
+    dist[m]->assign(graph.size(), HUGE_VAL);
+  }
+  vector<uint8_t> dirty(graph.size(), 0);
+  priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> q;
+  for (auto& [source, start] : sources) {
+    for (size_t m = 0; m < metrics; m++) {
+      if (start[m] < (*dist[m])[source]) {
+        (*dist[m])[source] = start[m];
+        dirty[source] |= 1 << m;
+      }
+    }
+    q.push({(*dist[0])[source], source});
+  }
+  bool check_inactive = !inactive.empty();
+  while (!q.empty()) {
+    auto [d, cur] = q.top();
+    q.pop();
+    uint8_t mask = dirty[cur];
+    if (!mask || d > (*dist[0])[cur])
+      continue;
+    dirty[cur] = 0;
+    double base[max_metrics];
+    for (size_t m = 0; m < metrics; m++)
+      base[m] = (*dist[m])[cur];
+    for (link* l : graph[cur]) {
+      if (check_inactive) {
+        auto it = inactive.find(l->id);
+        if (it != inactive.end() && it->second)
+          continue;
+      }
+      int next = graph.head(l);
+      uint8_t improved = 0;
+      for (size_t m = 0; m < metrics; m++) {
+        if (!(mask & (1 << m)))
+          continue;
+        double newDist = base[m] + weight(l, kind[m]);
+        if (newDist < (*dist[m])[next]) {
+          (*dist[m])[next] = newDist;
+          improved |= 1 << m;
+        }
+      }
+      if (improved) {
+        dirty[next] |= improved;
+        q.push({(*dist[0])[next], next});
+      }
+    }
+  }
+}
+
+void one_to_all(int source, const graph_view& graph,
+                const vector<pair<metric, vector<double>*>>& targets,
+                const unordered_map<int, bool>& inactive) {
+  many_to_all({{source, vector<double>(targets.size(), 0.0)}}, graph, targets, inactive);
+}
@@ -14,6 +14,7 @@
 using namespace tinyxml2;
 
 XMLDocument plansXml = XMLDocument();
+std::string graphFile;
 
 
 class LinkCollector : public XMLVisitor {
@@ -26,6 +27,7 @@ class LinkCollector : public XMLVisitor {
         l->capacity = std::atof(e.Attribute("capacity"));
         l->freespeed = std::atof(e.Attribute("freespeed"));
         adj.at(l->from).push_back(l);
+        adj_inv.at(l->to).push_back(l);
     }
     void handleNode(const XMLElement& e) {
         node* n = new node;
@@ -54,13 +56,15 @@ public:
     int maxId = 0;
 };
 
-void loadGraph(const char* graphFile) {
+void loadGraph(const char* graphFileName) {
+    graphFile = graphFileName;
     XMLDocument input;
-    input.LoadFile(graphFile);
+    input.LoadFile(graphFileName);
     NodeCounter cnt;
     input.Accept(&cnt);
     nodes.resize(cnt.maxId+1);
     adj.resize(cnt.maxId+1);
+    adj_inv.resize(cnt.maxId+1);
     LinkCollector linkCollector;
     input.Accept(&linkCollector);
 }
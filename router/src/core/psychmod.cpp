@@ -1,6 +1,7 @@
 
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <unordered_map>
 
 #include <gsl/gsl_poly.h>
@@ -84,6 +85,59 @@ pair<double, int> psychmod::score_route(double ap, double bp, double aq, double
   return {score, usage};
 }
 
+void psychmod::score_routes(size_t n, const double* ap, const double* bp, double aq, double bq,
+                            const double* apnq, const double* bpnq, int k, double* scores,
+                            int* usages) {
+  for (size_t i = 0; i < n; i++)
+    tie(scores[i], usages[i]) = score_route(ap[i], bp[i], aq, bq, apnq[i], bpnq[i], k);
+}
+
+namespace {
+
+// The latency of linear_simple_example_model_2r and the quadratic solver of GSL
+// (gsl_poly_solve_quadratic) for a single lane of a batch. Both do the same floating point
+// operations as the originals, so the batch scores equal those of score_route. The solver
+// computes every case and selects the one GSL would take instead of branching (and the lanes
+// combine conditions with & instead of &&), which lets the batch loops be vectorized. Missing
+// roots keep the values passed in, like GSL leaves them untouched.
+inline double lane_latency(double a, double b, double x) { return a * x * x + b; }
+
+struct lane_roots {
+  double x0, x1;
+};
+
+inline lane_roots lane_solve_quadratic(double a, double b, double c, double x0, double x1) {
+  double disc = b * b - 4 * a * c;
+  double sgnb = (b > 0 ? 1 : -1);
+  double temp = -0.5 * (b + sgnb * sqrt(disc > 0 ? disc : 0));
+  double r1 = temp / a;
+  double r2 = c / temp;
+  double r = sqrt(-c / a > 0 ? -c / a : 0);
+  double lo = b == 0 ? -r : (r1 < r2 ? r1 : r2);
+  double hi = b == 0 ? r : (r1 < r2 ? r2 : r1);
+  double double_root = -0.5 * b / a;
+  double linear_root = -c / b;
+  bool two = (a != 0) & (disc > 0), one = (a != 0) & (disc == 0), linear = (a == 0) & (b != 0);
+  x0 = linear ? linear_root : x0;
+  x0 = one ? double_root : x0;
+  x1 = one ? double_root : x1;
+  x0 = two ? lo : x0;
+  x1 = two ? hi : x1;
+  return {x0, x1};
+}
+
+// the score of usage u, as in the loop of psychmod::score_route
+inline int lane_score(double ap, double bp, double aq, double bq, double apnq, double bpnq,
+                      int k, double overlapping_latency, double u) {
+  double l_p = lane_latency(ap - apnq, bp - bpnq, u);
+  double l_q = lane_latency(aq - apnq, bq - bpnq, k - u);
+  int _score = u * l_p + (k - u) * l_q + k * overlapping_latency;
+  // Overflow! (score_route assigns the largest double, which becomes the largest int)
+  return _score < 0 ? numeric_limits<int>::max() : _score;
+}
+
+}  // namespace
+
 double linear_simple_example_model_2r::latency(double a, double b, double x) {
   return a * x * x + b;
 }
@@ -95,13 +149,15 @@ double linear_simple_example_model_2r::a(link& l) {
 double linear_simple_example_model_2r::b(link& l) { return l.length / l.freespeed; }
 
 bool linear_simple_example_model_2r::dominating(shared_ptr<ParetoElement> par1,
-                                                         shared_ptr<ParetoElement> par2) {
-   return par1->b() <= par2->b() && par1->taud() <= par2->taud();
+                                                         shared_ptr<ParetoElement> par2, double eps) {
+   double f = 1 + eps;
+   return par1->b() <= f * par2->b() && par1->taud() <= f * par2->taud();
 }
 
 bool linear_simple_example_model_2r::strongly_dominating(shared_ptr<ParetoElement> par1,
-                                                         shared_ptr<ParetoElement> par2) {
-   return par1->b() <= par2->b() && par1->taud() <= par2->taud() && par1->shared_a() <= par2->shared_a();
+                                                         shared_ptr<ParetoElement> par2, double eps) {
+   double f = 1 + eps;
+   return par1->b() <= f * par2->b() && par1->taud() <= f * par2->taud() && par1->shared_a() <= f * par2->shared_a();
 }
 
 vector<double> linear_simple_example_model_2r::calc_usage(double ap, double bp, double aq,
@@ -193,7 +249,7 @@ vector<double> user_equilibrium_2r::calc_usage(double a_p, double b_p, double a_
     double A = (3 * pa - 3 * qa);  // x^2,
     double B = (6 * qa * k);       // x,
     double C = (pb - qb - 3 * qa * k * k);
-    double x0, x1;
+    double x0 = -1, x1 = -1;
     gsl_poly_solve_quadratic(A, B, C, &x0, &x1);
     vector<double> in_bounds;
     in_bounds.push_back(k);
@@ -208,4 +264,73 @@ vector<double> user_equilibrium_2r::calc_usage(double a_p, double b_p, double a_
     return {0.0f};
   }
   return in_bounds;
-}
\ No newline at end of file
+}
+
+void user_equilibrium_2r::score_routes(size_t n, const double* a_p, const double* b_p,
+                                       double a_q, double b_q, const double* apnq,
+                                       const double* bpnq, int k, double* scores, int* usages) {
+#pragma omp simd
+  for (size_t i = 0; i < n; i++) {
+    double overlapping_latency = lane_latency(apnq[i], bpnq[i], k);
+    double aq = a_q - apnq[i];
+    double bq = b_q - bpnq[i] + overlapping_latency;
+    double ap = a_p[i] - apnq[i];
+    double bp = b_p[i] - bpnq[i] + overlapping_latency;
+
+    double A = ap - aq;
+    double B = 2 * aq * k;
+    double C = bp - bq - aq * k * k;
+
+    auto [x0, x1] = lane_solve_quadratic(A, B, C, -1, -1);
+    double u = lane_latency(ap, bp, k) <= lane_latency(aq, bq, 0) ? k : 0;
+    u = (0 <= x1) & (x1 <= k) ? x1 : u;
+    u = (0 <= x0) & (x0 <= k) ? x0 : u;
+    scores[i] = lane_score(a_p[i], b_p[i], a_q, b_q, apnq[i], bpnq[i], k, overlapping_latency, u);
+    usages[i] = u;
+  }
+}
+
+void system_optimum_2r::score_routes(size_t n, const double* ap, const double* bp, double aq,
+                                     double bq, const double* apnq, const double* bpnq, int k,
+                                     double* scores, int* usages) {
+#pragma omp simd
+  for (size_t i = 0; i < n; i++) {
+    double qa = aq - apnq[i];
+    double qb = bq - bpnq[i];
+    double pa = ap[i] - apnq[i];
+    double pb = bp[i] - bpnq[i];
+
+    double A = (3 * pa - 3 * qa);
+    double B = (6 * qa * k);
+    double C = (pb - qb - 3 * qa * k * k);
+    auto [x0, x1] = lane_solve_quadratic(A, B, C, -1, -1);
+
+    // the candidates of calc_usage in its order, the first one with the lowest score wins
+    double overlapping_latency = lane_latency(apnq[i], bpnq[i], k);
+    double u = k;
+    int score = lane_score(ap[i], bp[i], aq, bq, apnq[i], bpnq[i], k, overlapping_latency, k);
+    int s0 = lane_score(ap[i], bp[i], aq, bq, apnq[i], bpnq[i], k, overlapping_latency, 0);
+    u = s0 < score ? 0 : u;
+    score = s0 < score ? s0 : score;
+    int s1 = lane_score(ap[i], bp[i], aq, bq, apnq[i], bpnq[i], k, overlapping_latency, x0);
+    bool better = (0 <= x0) & (x0 <= k) & (s1 < score);
+    u = better ? x0 : u;
+    score = better ? s1 : score;
+    int s2 = lane_score(ap[i], bp[i], aq, bq, apnq[i], bpnq[i], k, overlapping_latency, x1);
+    better = (0 <= x1) & (x1 <= k) & (s2 < score);
+    u = better ? x1 : u;
+    score = better ? s2 : score;
+    scores[i] = score;
+    usages[i] = u;
+  }
+}
+
+unique_ptr<psychmod> make_psychmod(const string& name) {
+  if (name == "linear_simple_example_model_2r")
+    return make_unique<linear_simple_example_model_2r>();
+  if (name == "user_equilibrium_2r")
+    return make_unique<user_equilibrium_2r>();
+  if (name == "system_optimum_2r")
+    return make_unique<system_optimum_2r>();
+  return nullptr;
+}
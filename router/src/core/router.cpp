@@ -13,6 +13,7 @@
 std::vector<person> persons = {};
 std::vector<node*> nodes = {};
 std::vector<std::vector<link*>> adj = {};
+std::vector<std::vector<link*>> adj_inv = {};
 PSYCH_MODEL_CLASS psychological_model;
 
 int main(int argc, char *argv[]) {
@@ -8,6 +8,7 @@
 #include <utility>
 #include <vector>
 
+#include "core/corridor.h"
 #include "core/data.h"
 #include "core/globals.h"
 #include "core/io.h"
@@ -69,6 +70,11 @@ void do_ea(int origin, int destination, const std::vector<int>& pids) {
 
   parse_env();
   setup_logs();
+  int global_origin = origin, global_destination = destination;
+  if (od_corridor.enter(origin, destination, corridor_kind, corridor_slack)) {
+    origin = od_corridor.local(origin);
+    destination = od_corridor.local(destination);
+  }
 
   std::vector<island> islands(islandsCount, island(inds, n));
   initialize_islands(islands, k, origin, destination);
@@ -82,9 +88,10 @@ void do_ea(int origin, int destination, const std::vector<int>& pids) {
   individual* best = getBestIndividual(islands);
   int best_score = static_cast<int>(std::round(best->score));
   assign_routes(best->routes, best->u);
-  outputPlansToNewFile(get_intermediate_filename(0, best_score).c_str());
+  od_corridor.outside(
+      [&] { outputPlansToNewFile(get_intermediate_filename(0, best_score).c_str()); });
 
-  inform_about_settings(k, origin, destination, best_score);
+  inform_about_settings(k, global_origin, global_destination, best_score);
 
   int iteration = 1;
   int overallIterationsWithoutChange = 0;
@@ -129,7 +136,8 @@ void do_ea(int origin, int destination, const std::vector<int>& pids) {
     int new_score = static_cast<int>(std::round(best->score));
     if (best_score != new_score) {
       assign_routes(best->routes, best->u);
-      outputPlansToNewFile(get_intermediate_filename(iteration, new_score).c_str());
+      od_corridor.outside(
+          [&] { outputPlansToNewFile(get_intermediate_filename(iteration, new_score).c_str()); });
     }
 
     best_score = new_score;
@@ -146,6 +154,7 @@ void do_ea(int origin, int destination, const std::vector<int>& pids) {
 
   std::cout << "Dumping logs" << std::endl;
   close_logs(iteration, overallIterationsWithoutChange);
+  od_corridor.leave();
   std::cout << "Done." << std::endl;
 }
 
@@ -5,9 +5,11 @@
 #include <iostream>
 #include <sstream>
 
+#include "core/corridor.h"
 #include "ea/ea_crossover.h"
 #include "ea/ea_defaults.h"
 #include "ea/ea_globals.h"
+#include "ssotd/ssotd_defaults.h"  // the corridor defaults, shared with SSOTD
 
 #define STRINGIFY(x) #x           // NOLINT(cppcoreguidelines-macro-usage)
 #define TOSTRING(x) STRINGIFY(x)  // NOLINT(cppcoreguidelines-macro-usage)
@@ -22,6 +24,8 @@ std::string intermediate_results_prefix;
 std::string intermediate_folder;
 individual (*crossover_func)(individual&, individual&, int);
 std::string crossover_func_str;
+std::string corridor_kind;
+double corridor_slack;
 
 bool interrupted = false;
 void signal_handler(int signal_num) {
@@ -127,6 +131,9 @@ void parse_env() {
       crossover_func = &makeHeuristicBaby2;
     }
   }
+
+  parse_corridor_env("EA", default_corridor, default_corridor_slack, corridor_kind,
+                     corridor_slack);
 }
 
 auto get_intermediate_filename(int iteration, int score) -> std::string {
@@ -147,6 +154,7 @@ void inform_about_settings(int k, int origin, int destination, int score) {
             << std::endl;
   std::cout << "Drivers (k): " << k << std::endl;
   std::cout << "Routing from " << origin << " to " << destination << std::endl;
+  std::cout << "Corridor: " << corridor_kind << " (slack " << corridor_slack << ")" << std::endl;
   std::cout << "Queue Size: " << queue_size << std::endl;
   std::cout << "Initial best score: " << score << std::endl;
   std::cout << "ScoringMethod: " << TOSTRING(SCORING_METHOD) << std::endl;
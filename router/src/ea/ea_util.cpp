@@ -7,6 +7,7 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_rng.h>
 
+#include "core/corridor.h"
 #include "core/data.h"
 #include "core/globals.h"
 #include "ea/ea_constants.h"
@@ -146,7 +147,7 @@ auto getBestIndividual(std::vector<island>& islands) -> individual* {
 void assign_routes(std::vector<route>& routes, const usage& u) {
   std::discrete_distribution<> d(u.routeFlow.begin(), u.routeFlow.end());
   for (auto& p : persons) {
-    p.r = std::make_shared<route>(routes[d(getGenerator())]);
+    p.r = std::make_shared<route>(od_corridor.to_global(routes[d(getGenerator())]));
   }
 }
 
@@ -0,0 +1,287 @@
+#include "ssotd/ssotd_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "core/alt.h"
+#include "core/globals.h"
+#include "ssotd/ssotd_globals.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+#define STRINGIFY(x) #x
+#define MODEL_NAME(x) STRINGIFY(x)
+
+static constexpr char front_magic[4] = {'P', 'F', 'C', '1'};
+
+namespace {
+
+struct cache_stats {
+  long long hits = 0, misses = 0, stores = 0, evictions = 0;
+  uintmax_t bytes_read = 0, bytes_written = 0;
+};
+cache_stats stats;
+
+// the files of the cache directory, with their size and last use (their modification time)
+struct cached_file {
+  uintmax_t size;
+  fs::file_time_type used;
+};
+map<string, cached_file> cache_index;
+uintmax_t cache_bytes = 0;
+bool indexed = false;
+
+// scans the cache directory (creating it if needed) once per run
+void build_index() {
+  if (indexed)
+    return;
+  indexed = true;
+  error_code ec;
+  fs::create_directories(front_cache_dir, ec);
+  for (auto it = fs::directory_iterator(front_cache_dir, ec); !ec && it != fs::directory_iterator();
+       it.increment(ec)) {
+    if (it->path().extension() != ".pfc")
+      continue;
+    cached_file f{it->file_size(ec), it->last_write_time(ec)};
+    if (ec)
+      continue;
+    cache_index[it->path().string()] = f;
+    cache_bytes += f.size;
+  }
+}
+
+void record(const string& path, uintmax_t size) {
+  if (auto it = cache_index.find(path); it != cache_index.end())
+    cache_bytes -= it->second.size;
+  cache_index[path] = {size, fs::file_time_type::clock::now()};
+  cache_bytes += size;
+}
+
+// removes the least recently used files until the cache fits into SSOTD_FRONT_CACHE_MB
+void evict() {
+  uintmax_t limit = static_cast<uintmax_t>(front_cache_mb) << 20;
+  while (cache_bytes > limit && !cache_index.empty()) {
+    auto oldest = cache_index.begin();
+    for (auto it = cache_index.begin(); it != cache_index.end(); ++it)
+      if (it->second.used < oldest->second.used)
+        oldest = it;
+    error_code ec;
+    fs::remove(oldest->first, ec);
+    cache_bytes -= oldest->second.size;
+    cache_index.erase(oldest);
+    stats.evictions++;
+  }
+}
+
+template <class T>
+void put(FILE* out, const T& value) {
+  fwrite(&value, sizeof(value), 1, out);
+}
+
+template <class T>
+bool get(ifstream& in, T& value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+}  // namespace
+
+front_cache_slot::front_cache_slot(const string& variant, int a, int b, int k,
+                                   const route& original_route) {
+  if (front_cache_dir.empty())
+    return;
+  ostringstream desc;
+  desc << setprecision(17) << string(front_magic, sizeof(front_magic)) << ' '
+       << graph_fingerprint() << ' ' << variant << ' ' << a << ' ' << b << ' ' << k << ' '
+       << MODEL_NAME(PSYCH_MODEL_CLASS);
+  for (auto& model : evaluation_models)
+    desc << ',' << model;
+  desc << ' ' << pareto_epsilon << ' ' << simple_paths << ' ' << bound_mode << ' '
+       << parallel_search << ' ' << compact_labels;
+  for (link* l : original_route.links)
+    desc << ' ' << l->id;
+  // FNV-1a, like graph_fingerprint
+  key = 14695981039346656037ULL;
+  auto mix = [this](const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+      key ^= bytes[i];
+      key *= 1099511628211ULL;
+    }
+  };
+  string text = desc.str();
+  mix(text.data(), text.size());
+  // the latencies the searches see: link::taud caches the one of the agent count it was first
+  // asked for, which need not be k
+  for (auto& links : adj)
+    for (link* l : links) {
+      double taud = l->taud();
+      mix(&taud, sizeof(taud));
+    }
+  ostringstream name;
+  name << hex << setw(16) << setfill('0') << key << ".pfc";
+  path = (fs::path(front_cache_dir) / name.str()).string();
+}
+
+// File layout: magic, {key, #labels, #fronts}, then per label {parent, link id} (int32, -1 for
+// none; parents come first), hasSplit (uint8) and {a, b, taud, shared_a, shared_b, shared_taud,
+// cover} (double), then per front {i, j, #labels} and the label numbers (int32).
+bool front_cache_slot::load(front_map& fronts) {
+  if (path.empty())
+    return false;
+  build_index();
+  auto start = chrono::steady_clock::now();
+  ifstream in(path, ios::binary);
+  char magic[4];
+  uint64_t header[3];
+  bool ok = in.read(magic, sizeof(magic)) && memcmp(magic, front_magic, sizeof(magic)) == 0 &&
+            get(in, header) && header[0] == key;
+  vector<shared_ptr<ParetoElement>> labels;
+  if (ok) {
+    unordered_map<int, link*> links;
+    for (auto& out : adj)
+      for (link* l : out)
+        links[l->id] = l;
+    labels.reserve(header[1]);
+    for (uint64_t i = 0; ok && i < header[1]; i++) {
+      int32_t ids[2];
+      uint8_t split;
+      double values[7];
+      ok = get(in, ids) && get(in, split) && get(in, values) && ids[0] < static_cast<int64_t>(i);
+      link* l = nullptr;
+      if (ok && ids[1] >= 0) {
+        auto it = links.find(ids[1]);
+        ok = it != links.end();
+        l = ok ? it->second : nullptr;
+      }
+      if (!ok)
+        break;
+      labels.push_back(make_shared<ParetoElement>(ids[0] >= 0 ? labels[ids[0]] : nullptr, l,
+                                                  values[0], values[1], values[2], values[3],
+                                                  values[4], values[5], values[6]));
+      labels.back()->hasSplit = split;
+    }
+    for (uint64_t f = 0; ok && f < header[2]; f++) {
+      int32_t front_header[3];
+      ok = get(in, front_header) && front_header[2] >= 0;
+      if (!ok)
+        break;
+      auto& front = fronts[{front_header[0], front_header[1]}];
+      for (int32_t i = 0; ok && i < front_header[2]; i++) {
+        int32_t id;
+        ok = get(in, id) && id >= 0 && static_cast<size_t>(id) < labels.size();
+        if (ok)
+          front.push_back(labels[id]);
+      }
+    }
+  }
+  if (!ok) {
+    fronts.clear();
+    stats.misses++;
+    cout << "Front cache miss" << endl;
+    return false;
+  }
+  error_code ec;
+  uintmax_t size = fs::file_size(path, ec);
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  record(path, size);
+  stats.hits++;
+  stats.bytes_read += size;
+  auto end = chrono::steady_clock::now();
+  cout << "Front cache hit: " << labels.size() << " labels in " << fronts.size() << " fronts ("
+       << size << " bytes), load time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  return true;
+}
+
+void front_cache_slot::store(const front_map& fronts) {
+  if (path.empty())
+    return;
+  build_index();
+  // number the labels and their prefixes, every prefix before its extensions
+  unordered_map<const ParetoElement*, int32_t> ids;
+  vector<const ParetoElement*> order, chain;
+  for (auto& [ij, front] : fronts)
+    for (auto& par : front) {
+      chain.clear();
+      for (auto p = par; p && !ids.count(p.get()); p = p->get_parent())
+        chain.push_back(p.get());
+      for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        ids[*it] = order.size();
+        order.push_back(*it);
+      }
+    }
+
+  // written under a unique name first, so that no run reads a half-written file and runs that
+  // store the same key at once do not write into the same file
+  string tmp = path + ".XXXXXX";
+  int fd = mkstemp(tmp.data());
+  FILE* out = fd < 0 ? nullptr : fdopen(fd, "wb");
+  error_code ec;
+  if (!out) {
+    cerr << "Could not create a front cache file next to " << path << endl;
+    if (fd >= 0)
+      fs::remove(tmp, ec);
+    return;
+  }
+  // mkstemp creates the file for its owner only, the cache may be shared
+  fs::permissions(tmp,
+                  fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read |
+                      fs::perms::others_read,
+                  ec);
+  uint64_t header[3] = {key, order.size(), fronts.size()};
+  put(out, front_magic);
+  put(out, header);
+  for (auto p : order) {
+    auto parent = p->get_parent();
+    int32_t label_ids[2] = {parent ? ids[parent.get()] : -1, p->myLink ? p->myLink->id : -1};
+    uint8_t split = p->hasSplit;
+    double values[7] = {p->a(),        p->b(),        p->taud(),     p->shared_a(),
+                        p->shared_b(), p->shared_taud(), p->own_cover()};
+    put(out, label_ids);
+    put(out, split);
+    put(out, values);
+  }
+  for (auto& [ij, front] : fronts) {
+    int32_t front_header[3] = {ij.first, ij.second, static_cast<int32_t>(front.size())};
+    put(out, front_header);
+    for (auto& par : front)
+      put(out, ids[par.get()]);
+  }
+  bool failed = ferror(out) != 0;
+  failed |= fclose(out) != 0;
+  if (failed) {
+    cerr << "Could not write the front cache file " << tmp << endl;
+    fs::remove(tmp, ec);
+    return;
+  }
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    cerr << "Could not write the front cache file " << path << ": " << ec.message() << endl;
+    fs::remove(tmp, ec);
+    return;
+  }
+  uintmax_t size = fs::file_size(path, ec);
+  record(path, size);
+  stats.stores++;
+  stats.bytes_written += size;
+  cout << "Stored " << order.size() << " labels in the front cache (" << size << " bytes)" << endl;
+  evict();
+}
+
+void print_front_cache_stats() {
+  if (front_cache_dir.empty())
+    return;
+  cout << "Front cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.stores
+       << " stored, " << stats.evictions << " evicted, " << stats.bytes_read << " bytes read, "
+       << stats.bytes_written << " bytes written, " << cache_index.size() << " files ("
+       << cache_bytes << " bytes)" << endl;
+}
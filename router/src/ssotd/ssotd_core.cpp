@@ -4,16 +4,32 @@
 #include <any>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iostream>
 #include <list>
+#include <map>
 #include <memory>
 #include <numeric>
+#include <omp.h>
 #include <queue>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 
 #include "core/data.h"
+#include "core/alt.h"
+#include "core/ch.h"
+#include "core/corridor.h"
+#include "core/geometric.h"
 #include "core/globals.h"
+#include "core/graph.h"
+#include "core/io.h"
+#include "ssotd/ssotd_defaults.h"
+#include "ssotd/ssotd_globals.h"
 
 template <class T>
 using minq = priority_queue<T, vector<T>, greater<>>;
@@ -32,16 +48,269 @@ vector<double> origTt, origPartA, origPartB;  // original route prefix sums
 
 unordered_map<int, int> nodes_original_route;  // maps a node id to its index in orig route
 
+vector<double> rejoinAs, rejoinBs;
+
+thread_local bound_trace last_bound;
+
 int to_node;
 double max_sharedA;
 double mean_taud;
 shared_ptr<route> orig_path;
+chrono::steady_clock::time_point od_deadline;
 
-shared_ptr<route> dijkstra(int a, int b, shared_ptr<route> original_route) {
-  unordered_map<int, bool> inactive;
-  if (original_route)
-    for_each(original_route->links.begin(), original_route->links.end(),
-             [&inactive](link* l) { inactive[l->id] = true; });
+void start_deadline() {
+  od_deadline = chrono::steady_clock::now() + chrono::milliseconds(deadline_ms);
+}
+
+bool deadline_passed() {
+  return deadline_ms > 0 && chrono::steady_clock::now() > od_deadline;
+}
+
+void search_info::merge(const search_info& other) {
+  timed_out = timed_out || other.timed_out;
+  over_budget = over_budget || other.over_budget;
+  lower_bound = min(lower_bound, other.lower_bound);
+  if (other.relaxed_ot < relaxed_ot) {
+    relaxed_ot = other.relaxed_ot;
+    relaxed_par = other.relaxed_par;
+    relaxed_from = other.relaxed_from;
+    relaxed_to = other.relaxed_to;
+  }
+  for (int r = 0; r < 3; r++)
+    pruned[r] += other.pruned[r];
+  revisits += other.revisits;
+  created += other.created;
+  dominated += other.dominated;
+  pushes += other.pushes;
+  pops += other.pops;
+}
+
+// index of the rule that pruned the last label scored (on this thread)
+int pruned_rule(double qot) {
+  bool by_target = last_bound.rule == bound_rule::target || last_bound.target_bound > qot + 100;
+  return static_cast<int>(by_target ? bound_rule::target : last_bound.rule);
+}
+
+void count_pruned(search_info* info, double qot) {
+  if (info)
+    info->pruned[pruned_rule(qot)]++;
+}
+
+void print_pruned(const search_info& info) {
+  cout << "Pruned labels: " << info.pruned[static_cast<int>(bound_rule::target)] << " by target, "
+       << info.pruned[static_cast<int>(bound_rule::rejoin)] << " by rejoin, "
+       << info.pruned[static_cast<int>(bound_rule::suffix)] << " by suffix bound";
+  if (simple_paths)
+    cout << ", " << info.revisits << " revisiting a node";
+  cout << endl;
+}
+
+// Checks the deadline every few visits. Once it has passed, the labels left in the queue are
+// drained to get the lower bound of everything the search did not explore.
+template <class Q>
+bool stop_search(Q& q, ll visits, search_info* info,
+                 function<double(shared_ptr<ParetoElement>, int)> lower_bound) {
+  if (visits % 64 != 0 || !deadline_passed())
+    return false;
+  if (info) {
+    info->timed_out = true;
+    while (!q.empty()) {
+      auto [par, u] = q.top();
+      q.pop();
+      info->lower_bound = min(info->lower_bound, lower_bound(par, u));
+    }
+  }
+  return true;
+}
+
+// remembers the detour that relaxed qot, so it can be returned if the search is cut short
+void note_relaxed(search_info* info, double ot, shared_ptr<ParetoElement>& par, int from, int to) {
+  if (!info || ot >= info->relaxed_ot)
+    return;
+  info->relaxed_ot = ot;
+  info->relaxed_par = par;
+  info->relaxed_from = from;
+  info->relaxed_to = to;
+}
+
+// Keeps a search within SSOTD_LABEL_BUDGET labels (in the Pareto sets and in the queue). Each time
+// the search goes over budget, it brings the labels down to 3/4 of the budget, so it does not
+// run into the budget again right away. It first forgets the queued labels that have left their
+// Pareto set since they were queued. Then it coarsens to epsilon-dominance and thins out the
+// Pareto sets it already has, doubling epsilon (up to budget_max_epsilon) only while that is not
+// enough. Last, it drops the queued labels with the highest lower bound, but keeps at least an
+// eighth of the budget queued. Once epsilon is at its maximum, only the queue is limited (to a
+// quarter of the budget, if the Pareto sets take up the rest).
+template <class Q>
+void enforce_label_budget(Q& q, vector<label_front>& pareto, ll& labels,
+                          double& eps, bool strong, search_info* info,
+                          function<double(shared_ptr<ParetoElement>, int)> lower_bound, int from,
+                          int to, int a) {
+  ll queue_size = static_cast<ll>(q.size());
+  if (label_budget <= 0 || labels + queue_size <= label_budget)
+    return;
+  if (eps >= budget_max_epsilon && queue_size <= label_budget / 4)
+    return;
+  if (info)
+    info->over_budget = true;
+  cout << "Label budget of " << label_budget << " exceeded for OD " << from << " -> " << to
+       << " (search from " << a << ", " << labels << " labels, " << q.size() << " queued): ";
+
+  vector<pair<shared_ptr<ParetoElement>, int>> queued;
+  queued.reserve(q.size());
+  while (!q.empty()) {
+    queued.push_back(q.top());
+    q.pop();
+  }
+  // the start label is in no Pareto set
+  auto drop_stale = [&pareto, &queued]() {
+    unordered_set<int> nodes;
+    unordered_set<const ParetoElement*> live;
+    for (auto& entry : queued)
+      if (nodes.insert(entry.second).second)
+        for (auto& par : pareto[entry.second])
+          live.insert(par.get());
+    size_t kept = 0;
+    for (auto& entry : queued)
+      if (!entry.first->myLink || live.count(entry.first.get()))
+        queued[kept++] = move(entry);
+    ll stale = static_cast<ll>(queued.size() - kept);
+    queued.resize(kept);
+    return stale;
+  };
+  ll target = label_budget * 3 / 4;
+  ll stale = drop_stale();
+  cout << "forgot " << stale << " stale queued labels";
+
+  ll merged = 0;
+  while (labels + static_cast<ll>(queued.size()) > target && eps < budget_max_epsilon) {
+    eps = eps > 0 ? min(2 * eps, budget_max_epsilon) : budget_start_epsilon;
+    merged += labels;
+    labels = 0;
+    for (auto& front : pareto) {
+      label_front old_front;
+      old_front.swap(front);
+      for (auto& par : old_front)
+        insert_label(front, par, strong, eps);
+      labels += front.size();
+    }
+    merged -= labels;
+    stale += drop_stale();
+    cout << ", coarsened to epsilon " << eps;
+  }
+  if (merged > 0)
+    cout << ", merged " << merged << " labels (" << stale << " stale queued labels in total)";
+
+  if (labels + static_cast<ll>(queued.size()) > target) {
+    vector<pair<double, size_t>> bounds(queued.size());
+    for (size_t i = 0; i < queued.size(); i++)
+      bounds[i] = {lower_bound(queued[i].first, queued[i].second), i};
+    stable_sort(bounds.begin(), bounds.end(),
+                [](auto& left, auto& right) { return left.first < right.first; });
+    size_t keep = min(static_cast<ll>(queued.size()), max(label_budget / 8, target - labels));
+    if (keep < queued.size()) {
+      if (info)
+        info->lower_bound = min(info->lower_bound, bounds[keep].first);
+      cout << ", dropped " << queued.size() - keep << " queued labels with lower bound >= "
+           << bounds[keep].first;
+    }
+    for (size_t i = 0; i < keep; i++)
+      q.push(queued[bounds[i].second]);
+  } else {
+    for (auto& entry : queued)
+      q.push(entry);
+  }
+  cout << endl;
+}
+
+void enter_od_corridor(int& source, int& destination) {
+  if (!od_corridor.enter(source, destination, corridor_kind, corridor_slack))
+    return;
+  source = od_corridor.local(source);
+  destination = od_corridor.local(destination);
+}
+
+void leave_od_corridor(const vector<int>& pids) {
+  if (!od_corridor.active())
+    return;
+  map<route*, shared_ptr<route>> mapped;
+  for (int pid : pids) {
+    auto& global = mapped[persons[pid].r.get()];
+    if (!global)
+      global = make_shared<route>(od_corridor.to_global(*persons[pid].r));
+    persons[pid].r = global;
+  }
+  od_corridor.leave();
+}
+
+vector<od_group> od_groups() {
+  bool by_destination = bound_cache_size > 0 && corridor_kind == "none";
+  map<tuple<int, int, string>, vector<int>> groups;
+  for (unsigned int pid = 0; pid < persons.size(); pid++) {
+    auto& p = persons[pid];
+    if (by_destination)
+      groups[{p.destination, p.origin, p.timestr}].push_back(pid);
+    else
+      groups[{p.origin, p.destination, p.timestr}].push_back(pid);
+  }
+  vector<od_group> ordered;
+  for (auto& [key, pids] : groups) {
+    auto& [first, second, time] = key;
+    if (by_destination)
+      ordered.push_back({second, first, time, move(pids)});
+    else
+      ordered.push_back({first, second, time, move(pids)});
+  }
+  return ordered;
+}
+
+cch contraction;
+map<pair<metric, int>, unique_ptr<cch_metric>> customizations;
+
+// orders and contracts the graph (or loads the hierarchy from next to the graph) on first use
+void prepare_contraction() {
+  if (contraction.size() > 0)
+    return;
+  auto start = chrono::steady_clock::now();
+  string path = graphFile + ".cch";
+  uint64_t fingerprint = persist_ch ? graph_fingerprint() : 0;
+  if (persist_ch && contraction.load(path, fingerprint)) {
+    cout << "Loaded the contraction hierarchy from " << path << endl;
+  } else {
+    contraction.build();
+    if (persist_ch)
+      contraction.save(path, fingerprint);
+  }
+  auto end = chrono::steady_clock::now();
+  cout << "CH preprocessing time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << " ("
+       << contraction.arcs() << " arcs)" << endl;
+}
+
+const cch_metric& customized(metric m, int k) {
+  prepare_contraction();
+  auto& slot = customizations[{m, m == metric::taud ? k : 0}];
+  if (!slot) {
+    auto start = chrono::steady_clock::now();
+    function<double(link*)> weight;
+    if (m == metric::a)
+      weight = [](link* l) { return l->a(); };
+    else if (m == metric::b)
+      weight = [](link* l) { return l->b(); };
+    else
+      weight = [k](link* l) { return l->latency(k); };
+    slot = make_unique<cch_metric>(contraction, weight);
+    auto end = chrono::steady_clock::now();
+    cout << "CH customization time: "
+         << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  }
+  return *slot;
+}
+
+// Dijkstra from a to b by the given link weight, skipping the inactive links
+template <class Weight>
+shared_ptr<route> shortest_route(int a, int b, const unordered_map<int, bool>& inactive,
+                                 Weight weight) {
   vector<double> dist(adj.size(), HUGE_VAL);
   vector<pair<int, link*>> prec(adj.size(), {-1, nullptr});
   minq<pair<double, int>> q;
@@ -55,9 +324,9 @@ shared_ptr<route> dijkstra(int a, int b, shared_ptr<route> original_route) {
     if (d > dist[cur])
       continue;
     for (link* l : adj[cur]) {
-      if (original_route && inactive[l->id])
+      if (!inactive.empty() && inactive.count(l->id))
         continue;
-      double newDist = d + l->b();
+      double newDist = d + weight(l);
       if (newDist < dist[l->to]) {
         dist[l->to] = newDist;
         q.push({newDist, l->to});
@@ -82,28 +351,46 @@ shared_ptr<route> dijkstra(int a, int b, shared_ptr<route> original_route) {
   return r;
 }
 
-
-shared_ptr<vector<double>> dijkstra_for_opt(int v, bool doA, unordered_map<int, bool> inactive, vector<vector<link*>> adj2, bool forward) {
-  auto dist = make_shared<vector<double>>(adj2.size(), HUGE_VAL);
-  minq<pair<double, int>> q;
-  (*dist)[v] = 0.0f;
-  q.push({0.0f, v});
-  while (!q.empty()) {
-    auto [d, cur] = q.top();
-    q.pop();
-    if (d > (*dist)[cur])
-      continue;
-    for (link* l : adj2[cur]) {
-      if (inactive[l->id])
-        continue;
-      double newDist = doA ? d + l->a() : d + l->b();
-      if (newDist < (*dist)[forward ? l->to : l->from]) {
-        (*dist)[forward ? l->to : l->from] = newDist;
-        q.push({newDist, forward ? l->to : l->from});
-      }
+shared_ptr<route> dijkstra(int a, int b, shared_ptr<route> original_route) {
+  unordered_map<int, bool> inactive;
+  if (original_route)
+    for_each(original_route->links.begin(), original_route->links.end(),
+             [&inactive](link* l) { inactive[l->id] = true; });
+  if (use_ch && !od_corridor.active()) {
+    auto r = original_route ? customized(metric::b).without(inactive).query(a, b)
+                            : customized(metric::b).query(a, b);
+    if (!r || r->links.empty()) {
+      cerr << "WARNING!" << endl;
+      cerr << "(djikstra) could not find any route from " << a << " to " << b << endl;
+      exit(1);
     }
+    return r;
   }
-  return dist;
+  return shortest_route(a, b, inactive, [](link* l) { return l->b(); });
+}
+
+shared_ptr<route> latency_dijkstra(int a, int b, shared_ptr<route> original_route, double x) {
+  unordered_map<int, bool> inactive;
+  for (link* l : original_route->links)
+    inactive[l->id] = true;
+  return shortest_route(a, b, inactive, [x](link* l) { return l->latency(x); });
+}
+
+agent_count_scope::agent_count_scope(int k) : saved_count(number_agents) {
+  number_agents = k;
+  for (auto& out : adj)
+    for (link* l : out) {
+      saved_taud.push_back(l->_taud);
+      l->_taud = 0;
+    }
+}
+
+agent_count_scope::~agent_count_scope() {
+  number_agents = saved_count;
+  size_t i = 0;
+  for (auto& out : adj)
+    for (link* l : out)
+      l->_taud = saved_taud[i++];
 }
 
 bool standard_prio(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right) {
@@ -119,16 +406,93 @@ bool astar_prio_dijkstra(pair<shared_ptr<ParetoElement>, int> left, pair<shared_
   psychological_model.score_route(rightA, rightB, orig_path->a(), orig_path->b(), right.first->shared_a(), right.first->shared_b(), number_agents);
 }
 
+bool insert_label(label_front& front, shared_ptr<ParetoElement>& newPar, bool strong, double eps) {
+  // the front compares the criteria of the 2r models itself, see linear_simple_example_model_2r
+  static_assert(is_base_of_v<linear_simple_example_model_2r, PSYCH_MODEL_CLASS>);
+  auto dominates = [strong](shared_ptr<ParetoElement>& par1, shared_ptr<ParetoElement>& par2,
+                            double e) {
+    return strong ? psychological_model.strongly_dominating(par1, par2, e)
+                  : psychological_model.dominating(par1, par2, e);
+  };
+  // A label that is only epsilon-dominated is replaced by a label that is at most (1 + eps) times
+  // worse in every criterion. The replacing label remembers that factor (on top of the factor of
+  // the replaced label), so the approximation of the final routes can be bounded.
+  auto cover_factor = [&dominates, eps](shared_ptr<ParetoElement>& par1,
+                                        shared_ptr<ParetoElement>& par2) {
+    return (dominates(par1, par2, 0.0) ? 1.0 : 1.0 + eps) * par2->approx();
+  };
+
+  label_front::labels_type removed;
+  auto dominator = front.insert(newPar, strong, eps, eps > 0 ? &removed : nullptr);
+  if (dominator) {
+    if (eps > 0)
+      dominator->cover(cover_factor(dominator, newPar));
+    return false;
+  }
+  for (auto& vpar : removed)
+    newPar->cover(cover_factor(newPar, vpar));
+  return true;
+}
+
+double approximation_bound(const vector<shared_ptr<ParetoElement>>& front) {
+  double factor = 1.0;
+  for (auto& par : front)
+    factor = max(factor, par->approx());
+  return factor;
+}
+
 bool can_ignore(shared_ptr<ParetoElement> par, link* l) {
   return par->myLink && par->myLink->from == l->to;
 }
 
-pair<double, ll> pareto_dijkstra_local_opt(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+// The nodes of the path of one label, stamped when the label is expanded, so that each of its
+// extensions checks whether it revisits a node in constant time (SSOTD_SIMPLE_PATHS). Marking
+// walks the path once per expanded label, however long the path is.
+class path_marks {
+ public:
+  void mark(const ParetoElement& par) {
+    next();
+    for (auto p = &par; p->myLink != nullptr; p = p->get_parent().get())
+      stamp[p->myLink->from] = stamp[p->myLink->to] = current;
+  }
+  void mark(const compact_search& search, uint32_t label) {
+    next();
+    for (uint32_t i = label; search.labels[i].link != compact_search::none;
+         i = search.labels[i].parent) {
+      link* l = search.links[search.labels[i].link];
+      stamp[l->from] = stamp[l->to] = current;
+    }
+  }
+  bool contains(int v) const { return stamp[v] == current; }
+
+ private:
+  void next() {
+    stamp.resize(adj.size(), 0);  // corridors change the number of nodes
+    if (++current == 0) {
+      fill(stamp.begin(), stamp.end(), 0);
+      current = 1;
+    }
+  }
+  vector<uint32_t> stamp;
+  uint32_t current = 0;
+};
+
+// rejects extensions that would revisit a node of the path marked last (SSOTD_SIMPLE_PATHS)
+bool revisits(const path_marks& marks, int v, search_info* info) {
+  if (!simple_paths || !marks.contains(v))
+    return false;
+  if (info)
+    info->revisits++;
+  return true;
+}
+
+pair<double, ll> pareto_dijkstra_local_opt(int a, int from, int to, vector<label_front>& pareto,
                                shared_ptr<route> original_route, int k, double qot,
                                unordered_map<int, bool> inactive,
                                pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                                            shared_ptr<route>, int),
-                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>)) {
+                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                     search_info* info) {
   cout << "Finding pareto routes for " << a << "  using qot  " << qot << endl;
   to_node = to;
   max_sharedA = original_route->a();
@@ -144,45 +508,528 @@ pair<double, ll> pareto_dijkstra_local_opt(int a, int from, int to, vector<vecto
   ll visits = 0;
   auto zero_el = make_shared<ParetoElement>();
   q.push({zero_el, a});
+  auto queued_bound = [&](shared_ptr<ParetoElement> par, int u) {
+    return lower_bound_score(par, from, to, a, u, original_route, k).first;
+  };
+  ll labels = 0;
+  double eps = pareto_epsilon;
+  path_marks marks;
   while (!q.empty()) {
+    if (stop_search(q, visits, info, queued_bound))
+      break;
     visits++;
     auto [par, u] = q.top();
     q.pop();
+    count_pops(info);
+    if (simple_paths)
+      marks.mark(*par);
     for (link* l : adj[u]) {
       if (can_ignore(par,l) || inactive[l->id])
         continue;
       int v = l->to;
+      if (revisits(marks, v, info))
+        continue;
       auto newPar = make_shared<ParetoElement>(par, l);
       pair<double, double> ot = lower_bound_score(newPar, from, to, a, v, original_route, k);
 
       if (ot.first > qot + 100) {
+        count_pruned(info, qot);
         continue;
       }
       if (ot.second > 0 && ot.second < qot) {
         cout << "relaxed ot cap" << endl;
         qot = ot.second;
+        note_relaxed(info, ot.second, newPar, a, v);
       }
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.dominating(vpar, newPar);
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                    return psychological_model.dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      size_t before = pareto[v].size();
+      bool inserted = insert_label(pareto[v], newPar, false, eps);
+      if (inserted)
         q.push({newPar, v});
+      labels += static_cast<ll>(pareto[v].size()) - static_cast<ll>(before);
+      count_label(info, inserted, before, pareto[v].size());
+    }
+    enforce_label_budget(q, pareto, labels, eps, false, info, queued_bound, from, to, a);
+  }
+  return make_pair(qot, visits);
+}
+
+// The queue of the sequential search, which also lets the parallel search see the labels after
+// the top one.
+template <class T, class Compare>
+class open_queue : public priority_queue<T, vector<T>, Compare> {
+ public:
+  explicit open_queue(const Compare& compare) : priority_queue<T, vector<T>, Compare>(compare) {}
+
+  // the (at most) n entries that are popped next if nothing is pushed in between, found by a
+  // best-first walk of the binary heap
+  vector<T> peek(size_t n) const {
+    auto& heap = this->c;
+    auto& less = this->comp;
+    auto below = [&heap, &less](size_t i, size_t j) { return less(heap[i], heap[j]); };
+    priority_queue<size_t, vector<size_t>, decltype(below)> next(below);
+    if (!heap.empty())
+      next.push(0);
+    vector<T> top;
+    while (!next.empty() && top.size() < n) {
+      size_t i = next.top();
+      next.pop();
+      top.push_back(heap[i]);
+      for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < heap.size(); child++)
+        next.push(child);
+    }
+    return top;
+  }
+};
+
+pair<double, ll> pareto_dijkstra_parallel(int a, int from, int to, vector<label_front>& pareto,
+                                          shared_ptr<route> original_route, int k, double qot,
+                                          const unordered_map<int, bool>& inactive,
+                                          pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
+                                                                                    shared_ptr<route>, int),
+                                          bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                                          bool rescore, search_info* info) {
+  cout << "Finding pareto routes for " << a << " in parallel using qot " << qot << endl;
+  to_node = to;
+  max_sharedA = original_route->a();
+  mean_taud = psychological_model.latency(mean_a, mean_b, number_agents);
+  orig_path = original_route;
+  // an extension of a label, par is null if it was over the OT cap already when it was scored
+  struct candidate {
+    shared_ptr<ParetoElement> par;
+    int v;
+    pair<double, double> ot;
+    bound_trace trace;
+  };
+  struct expansion {
+    shared_ptr<ParetoElement> label;  // keeps the key of the expansion alive
+    vector<candidate> out;
+    ll revisits = 0;
+  };
+  auto excluded = [&inactive](link* l) {
+    auto it = inactive.find(l->id);
+    return it != inactive.end() && it->second;
+  };
+  // link::taud caches its value on first use, which must not happen concurrently
+  for (auto& out : adj)
+    for (link* l : out)
+      l->taud();
+
+  using entry = pair<shared_ptr<ParetoElement>, int>;
+  auto cmp = [prio](entry left, entry right) { return (*prio)(left, right); };
+  open_queue<entry, decltype(cmp)> q(cmp);
+  q.push({make_shared<ParetoElement>(), a});
+  auto queued_bound = [&](shared_ptr<ParetoElement> par, int u) {
+    return lower_bound_score(par, from, to, a, u, original_route, k).first;
+  };
+  ll visits = 0, rounds = 0, labels = 0, speculated = 0;
+  double eps = pareto_epsilon;
+  size_t window = 16 * omp_get_max_threads();
+  vector<path_marks> marks(omp_get_max_threads());  // one per thread
+  unordered_map<const ParetoElement*, expansion> expanded;
+  bool stopped = false;
+  while (!q.empty() && !stopped) {
+    rounds++;
+    // The labels next in the queue are expanded in parallel. The OT cap only falls, so an
+    // extension over the cap now is pruned when its label is popped as well.
+    vector<entry> next;
+    for (auto& e : q.peek(window))
+      if (!expanded.count(e.first.get()))
+        next.push_back(move(e));
+    vector<expansion> out(next.size());
+    double cap = qot;
+#pragma omp parallel for schedule(dynamic, 4)
+    for (size_t i = 0; i < next.size(); i++) {
+      auto& [par, u] = next[i];
+      auto& path = marks[omp_get_thread_num()];
+      out[i].label = par;
+      if (simple_paths)
+        path.mark(*par);
+      for (link* l : adj[u]) {
+        if (can_ignore(par, l) || excluded(l))
+          continue;
+        int v = l->to;
+        if (simple_paths && path.contains(v)) {
+          out[i].revisits++;
+          continue;
+        }
+        auto newPar = make_shared<ParetoElement>(par, l);
+        auto ot = lower_bound_score(newPar, from, to, a, v, original_route, k);
+        out[i].out.push_back({ot.first > cap + 100 ? nullptr : move(newPar), v, ot, last_bound});
       }
     }
+    speculated += next.size();
+    for (size_t i = 0; i < next.size(); i++)
+      expanded.emplace(next[i].first.get(), move(out[i]));
+
+    // The labels are popped, pruned, relaxed and inserted one after the other, exactly as in the
+    // sequential search, as long as the top of the queue has been expanded. So the result is the
+    // same as that of pareto_dijkstra_local_opt, for any number of threads.
+    while (!q.empty()) {
+      if (stop_search(q, visits, info, queued_bound)) {
+        stopped = true;
+        break;
+      }
+      auto it = expanded.find(q.top().first.get());
+      if (it == expanded.end())
+        break;
+      visits++;
+      q.pop();
+      count_pops(info);
+      if (info)
+        info->revisits += it->second.revisits;
+      for (auto& [newPar, v, ot, trace] : it->second.out) {
+        if (newPar && rescore)
+          ot = lower_bound_score(newPar, from, to, a, v, original_route, k);
+        else
+          last_bound = trace;
+        if (!newPar || ot.first > qot + 100) {
+          count_pruned(info, qot);
+          continue;
+        }
+        if (ot.second > 0 && ot.second < qot) {
+          cout << "relaxed ot cap" << endl;
+          qot = ot.second;
+          note_relaxed(info, ot.second, newPar, a, v);
+        }
+        size_t before = pareto[v].size();
+        bool inserted = insert_label(pareto[v], newPar, false, eps);
+        if (inserted)
+          q.push({newPar, v});
+        labels += static_cast<ll>(pareto[v].size()) - static_cast<ll>(before);
+        count_label(info, inserted, before, pareto[v].size());
+      }
+      expanded.erase(it);
+      enforce_label_budget(q, pareto, labels, eps, false, info, queued_bound, from, to, a);
+    }
   }
+  cout << "Parallel rounds: " << rounds << " with " << omp_get_max_threads() << " threads, "
+       << visits << " of " << speculated << " expanded labels popped" << endl;
   return make_pair(qot, visits);
 }
 
-pair<double, ll> pareto_dijkstra_local_opt_4d(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+// links from and to node 0 do not count, as in the ParetoElement constructor
+static bool counted(link* l) { return !(l->to == 0 && l->from == 0); }
+
+// float bounds of a double, one float step beyond the nearest float, which covers the rounding
+// of the double sums
+static float round_down(double x) { return nextafterf(static_cast<float>(x), -HUGE_VALF); }
+static float round_up(double x) { return nextafterf(static_cast<float>(x), HUGE_VALF); }
+
+size_t compact_search::bytes() const {
+  size_t total = labels.capacity() * sizeof(compact_label) + links.capacity() * sizeof(link*) +
+                 pareto.capacity() * sizeof(vector<uint32_t>) +
+                 queue_peak * sizeof(tuple<double, uint32_t, int>);
+  for (auto& front : pareto)
+    total += front.capacity() * sizeof(uint32_t);
+  return total;
+}
+
+pair<double, double> compact_search::exact_ab(uint32_t label) const {
+  vector<link*> path;
+  for (uint32_t i = label; labels[i].link != none; i = labels[i].parent)
+    path.push_back(links[labels[i].link]);
+  double a = 0, b = 0;
+  for (auto it = path.rbegin(); it != path.rend(); ++it)
+    if (counted(*it)) {
+      a += (*it)->a();
+      b += (*it)->b();
+    }
+  return {a, b};
+}
+
+shared_ptr<ParetoElement> compact_search::materialize(uint32_t label) const {
+  vector<link*> path;
+  for (uint32_t i = label; labels[i].link != none; i = labels[i].parent)
+    path.push_back(links[labels[i].link]);
+  auto par = make_shared<ParetoElement>();
+  for (auto it = path.rbegin(); it != path.rend(); ++it)
+    par = make_shared<ParetoElement>(par, *it);
+  return par;
+}
+
+pair<double, ll> pareto_dijkstra_compact(int a, int to, compact_search& search,
+                                         shared_ptr<route> original_route, int k, double qot,
+                                         const unordered_map<int, bool>& inactive,
+                                         pair<double, double> (*lower_bound_score)(double, double, int, int,
+                                                                                   shared_ptr<route>, int),
+                                         search_info* info) {
+  cout << "Finding pareto routes for " << a << "  using qot  " << qot << " (compact labels)" << endl;
+  auto& labels = search.labels;
+  labels.clear();
+  search.links.clear();
+  search.pareto.assign(adj.size(), {});
+  search.queue_peak = 0;
+  // the links of node u are first[u] .. first[u + 1] - 1
+  vector<uint32_t> first(adj.size() + 1, 0);
+  vector<bool> blocked;
+  for (size_t u = 0; u < adj.size(); u++) {
+    first[u + 1] = first[u] + adj[u].size();
+    for (link* l : adj[u]) {
+      search.links.push_back(l);
+      auto it = inactive.find(l->id);
+      blocked.push_back(it != inactive.end() && it->second);
+    }
+  }
+  auto bound = [&](const compact_label& par, int v) {
+    return lower_bound_score(par.a_lo, par.b_lo, to, v, original_route, k);
+  };
+  auto prio = [&](const compact_label& par, int v) {
+    return psychological_model.score_route(par.a_lo + bestAs[v], par.b_lo + bestBs[v],
+                                           original_route->a(), original_route->b(), 0, 0,
+                                           number_agents).first;
+  };
+  minq<tuple<double, uint32_t, int>> q;
+  path_marks marks;
+  labels.push_back({0, 0, 0, 0, 0, compact_search::none, compact_search::none});
+  q.push({0.0, 0, a});
+  ll visits = 0;
+  while (!q.empty()) {
+    if (visits % 64 == 0 && deadline_passed()) {
+      if (info) {
+        info->timed_out = true;
+        for (; !q.empty(); q.pop())
+          info->lower_bound = min(info->lower_bound,
+                                  bound(labels[get<1>(q.top())], get<2>(q.top())).first);
+      }
+      break;
+    }
+    visits++;
+    auto [prio_u, i, u] = q.top();
+    q.pop();
+    count_pops(info);
+    (void) prio_u;
+    compact_label par = labels[i];
+    if (simple_paths)
+      marks.mark(search, i);
+    for (uint32_t e = first[u]; e < first[u + 1]; e++) {
+      link* l = search.links[e];
+      if (blocked[e] || (par.link != compact_search::none && search.links[par.link]->from == l->to))
+        continue;
+      int v = l->to;
+      if (simple_paths && marks.contains(v)) {
+        if (info)
+          info->revisits++;
+        continue;
+      }
+      compact_label n = par;
+      n.parent = i;
+      n.link = e;
+      if (counted(l)) {
+        n.a_lo = round_down(par.a_lo + l->a());
+        n.b_lo = round_down(par.b_lo + l->b());
+        n.b_hi = round_up(par.b_hi + l->b());
+        n.taud_lo = round_down(par.taud_lo + l->taud());
+        n.taud_hi = round_up(par.taud_hi + l->taud());
+      }
+      pair<double, double> ot;
+      if (v == to) {
+        auto [pa, pb] = search.exact_ab(i);
+        if (counted(l)) {
+          pa += l->a();
+          pb += l->b();
+        }
+        ot = lower_bound_score(pa, pb, to, v, original_route, k);
+      } else {
+        ot = bound(n, v);
+      }
+      if (ot.first > qot + 100) {
+        count_pruned(info, qot);
+        continue;
+      }
+      if (ot.second > 0 && ot.second < qot) {
+        cout << "relaxed ot cap" << endl;
+        qot = ot.second;
+        if (info && ot.second < info->relaxed_ot) {
+          auto relaxed = make_shared<ParetoElement>(search.materialize(i), l);
+          note_relaxed(info, ot.second, relaxed, a, v);
+        }
+      }
+      auto& front = search.pareto[v];
+      size_t before = front.size();
+      bool dominated = any_of(front.begin(), front.end(), [&](uint32_t j) {
+        return labels[j].b_hi <= n.b_lo && labels[j].taud_hi <= n.taud_lo;
+      });
+      if (dominated) {
+        count_label(info, false, before, before);
+        continue;
+      }
+      front.erase(remove_if(front.begin(), front.end(),
+                            [&](uint32_t j) {
+                              return n.b_hi <= labels[j].b_lo && n.taud_hi <= labels[j].taud_lo;
+                            }),
+                  front.end());
+      uint32_t id = labels.size();
+      labels.push_back(n);
+      front.push_back(id);
+      q.push({prio(n, v), id, v});
+      count_label(info, true, before, front.size());
+    }
+    search.queue_peak = max(search.queue_peak, q.size());
+  }
+  cout << "Compact labels: " << labels.size() << " (" << search.bytes() << " bytes with the Pareto "
+       << "sets and the queue)" << endl;
+  return make_pair(qot, visits);
+}
+
+shared_ptr<route> bidirectional_result::collectRoute() const {
+  auto links = forward->collectLinks();
+  auto suffix = backward->collectLinks();
+  links->insert(links->end(), suffix->rbegin(), suffix->rend());
+  return make_shared<route>(*links);
+}
+
+bidirectional_result pareto_dijkstra_bidirectional(int a, int b, shared_ptr<route> original_route,
+                                                   int k, double qot,
+                                                   unordered_map<int, bool> inactive,
+                                                   search_info* info) {
+  cout << "Finding pareto routes from " << a << " and " << b << " using qot " << qot << endl;
+  struct queued {
+    double bound;
+    ll seq;  // ties are broken by insertion order, so that the search is deterministic
+    shared_ptr<ParetoElement> par;
+    int v;
+    bool operator>(const queued& other) const {
+      return tie(bound, seq) > tie(other.bound, other.seq);
+    }
+  };
+  // direction 0 searches from a on adj, direction 1 from b on adj_inv
+  vector<label_front> pareto[2] = {
+      vector<label_front>(adj.size()),
+      vector<label_front>(adj.size())};
+  minq<queued> q[2];
+  // the a and b of the queued labels of each direction, for the stopping rule below
+  multiset<double> queued_a[2], queued_b[2];
+  ll seq = 0;
+  auto push = [&](int d, double bound, shared_ptr<ParetoElement>& par, int v) {
+    q[d].push({bound, seq++, par, v});
+    queued_a[d].insert(par->a());
+    queued_b[d].insert(par->b());
+  };
+  for (int d = 0; d < 2; d++) {
+    int s = d == 0 ? a : b;
+    pareto[d][s].push_back(make_shared<ParetoElement>());
+    push(d, 0.0, pareto[d][s].back(), s);
+  }
+
+  auto score = [&](double sa, double sb) {
+    return psychological_model.score_route(sa, sb, original_route->a(), original_route->b(), 0, 0,
+                                           k);
+  };
+  auto lower_bound = [&](int d, shared_ptr<ParetoElement>& par, int v) {
+    auto bound = d == 0 ? score(par->a() + bestAs[v], par->b() + bestBs[v])
+                        : score(bestAsForward[v] + par->a(), bestBsForward[v] + par->b());
+    return bound.second > 0 ? bound.first : HUGE_VAL;
+  };
+  // if the joined route would pass a node of the forward part again on its backward part
+  path_marks joined;
+  auto overlap = [&joined](shared_ptr<ParetoElement>& forward,
+                           shared_ptr<ParetoElement>& backward) {
+    joined.mark(*forward);
+    for (auto p = backward.get(); p->myLink != nullptr; p = p->get_parent().get())
+      if (joined.contains(p->myLink->to))
+        return true;
+    return false;
+  };
+  bidirectional_result res;
+  // joins a new label with the labels of the other direction at its node
+  auto meet = [&](int d, shared_ptr<ParetoElement>& par, int v) {
+    for (auto& other : pareto[1 - d][v]) {
+      auto& forward = d == 0 ? par : other;
+      auto& backward = d == 0 ? other : par;
+      if (simple_paths && overlap(forward, backward))
+        continue;
+      auto [ot, usage] = score(forward->a() + backward->a(), forward->b() + backward->b());
+      res.meetings++;
+      if (usage > 0 && ot < res.ot) {
+        res.ot = ot;
+        res.usage = usage;
+        res.forward = forward;
+        res.backward = backward;
+        qot = min(qot, ot);
+      }
+    }
+  };
+
+  // A route that has not been joined yet leaves a queued forward label before it reaches a
+  // queued backward label: where the two searches overlap on it, its halves have been joined.
+  // Its OT is therefore at least the bound of either label, and at least the OT at the smallest
+  // queued a and b of both directions added up. Once one of them exceeds the cap, every route
+  // still to be joined does, too.
+  auto joined_bound = [&]() {
+    if (queued_a[0].empty() || queued_a[1].empty())
+      return HUGE_VAL;
+    auto bound = score(*queued_a[0].begin() + *queued_a[1].begin(),
+                       *queued_b[0].begin() + *queued_b[1].begin());
+    return bound.second > 0 ? bound.first : HUGE_VAL;
+  };
+  double eps = pareto_epsilon;
+  path_marks marks;
+  ll pops = 0;
+  while (!q[0].empty() && !q[1].empty()) {
+    double queued_bound = min(q[0].top().bound, q[1].top().bound);
+    if (max(q[0].top().bound, q[1].top().bound) > qot + 100 || joined_bound() > qot + 100) {
+      res.stopped_early = queued_bound <= qot + 100;
+      break;
+    }
+    if (pops++ % 64 == 0 && deadline_passed()) {
+      if (info) {
+        info->timed_out = true;
+        info->lower_bound = min(info->lower_bound, queued_bound);
+      }
+      break;
+    }
+    int d = q[0].size() <= q[1].size() ? 0 : 1;
+    auto [bound, id, par, u] = q[d].top();
+    q[d].pop();
+    (void)id;
+    queued_a[d].erase(queued_a[d].find(par->a()));
+    queued_b[d].erase(queued_b[d].find(par->b()));
+    count_pops(info);
+    // the OT cap went down since the label was queued, or the label has been dominated meanwhile
+    // (and whatever it leads to is dominated by the extensions of its dominator)
+    auto& front = pareto[d][u];
+    if (bound > qot + 100 || find(front.begin(), front.end(), par) == front.end())
+      continue;
+    (d == 0 ? res.forward_visits : res.backward_visits)++;
+    if (simple_paths)
+      marks.mark(*par);
+    for (link* l : d == 0 ? adj[u] : adj_inv[u]) {
+      if (inactive[l->id])
+        continue;
+      if (par->myLink && (d == 0 ? par->myLink->from == l->to : par->myLink->to == l->from))
+        continue;
+      int v = d == 0 ? l->to : l->from;
+      if (revisits(marks, v, info))
+        continue;
+      auto newPar = make_shared<ParetoElement>(par, l);
+      double ot = lower_bound(d, newPar, v);
+      if (ot > qot + 100)
+        continue;
+      size_t before = pareto[d][v].size();
+      bool inserted = insert_label(pareto[d][v], newPar, false, eps);
+      count_label(info, inserted, before, pareto[d][v].size());
+      if (!inserted)
+        continue;
+      meet(d, newPar, v);
+      push(d, ot, newPar, v);
+    }
+  }
+
+  for (int d = 0; d < 2; d++) {
+    ll labels = 0;
+    for (auto& front : pareto[d])
+      labels += front.size();
+    (d == 0 ? res.forward_labels : res.backward_labels) = labels;
+  }
+  return res;
+}
+
+pair<double, ll> pareto_dijkstra_local_opt_4d(int a, int from, int to, vector<label_front>& pareto,
                                shared_ptr<route> original_route, int k, double qot, unordered_map<int, bool> is_orig_edge,
                                pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                                            shared_ptr<route>, int),
-                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>)) {
+                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                     search_info* info) {
   cout << "Finding pareto routes for " << a << "  using qot  " << qot << endl;
   to_node = to;
   max_sharedA = original_route->a();
@@ -198,46 +1045,58 @@ orig_path = original_route;
   ll visits = 0;
   auto zero_el = make_shared<ParetoElement>();
   q.push({zero_el, a});
+  auto queued_bound = [&](shared_ptr<ParetoElement> par, int u) {
+    return lower_bound_score(par, from, to, a, u, original_route, k).first;
+  };
+  ll labels = 0;
+  double eps = pareto_epsilon;
+  path_marks marks;
   while (!q.empty()) {
+    if (stop_search(q, visits, info, queued_bound))
+      break;
     visits++;
     auto [par, u] = q.top();
     q.pop();
+    count_pops(info);
+    if (simple_paths)
+      marks.mark(*par);
     for (link* l : adj[u]) {
       if (can_ignore(par,l))
 	  continue;
       int v = l->to;
+      if (revisits(marks, v, info))
+        continue;
       auto newPar = make_shared<ParetoElement>(par, l, is_orig_edge[l->id]);
       pair<double, double> ot = lower_bound_score(newPar, from, to, a, v, original_route, k);
 
       if (ot.first > qot + 100) {
+        count_pruned(info, qot);
         continue;
       }
       if (ot.second > 0 && ot.second < qot) {
         cout << "relaxed ot cap" << endl;
         qot = ot.second;
+        note_relaxed(info, ot.second, newPar, a, v);
       }
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.strongly_dominating(vpar, newPar);
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                    return psychological_model.strongly_dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      size_t before = pareto[v].size();
+      bool inserted = insert_label(pareto[v], newPar, true, eps);
+      if (inserted)
         q.push({newPar, v});
-      }
+      labels += static_cast<ll>(pareto[v].size()) - static_cast<ll>(before);
+      count_label(info, inserted, before, pareto[v].size());
     }
+    enforce_label_budget(q, pareto, labels, eps, true, info, queued_bound, from, to, a);
   }
   return make_pair(qot, visits);
 }
 
 
-pair<double, ll> pareto_dijkstra_local_opt_4d_1D(int a, int from, int to, vector<vector<shared_ptr<ParetoElement>>>& pareto,
+pair<double, ll> pareto_dijkstra_local_opt_4d_1D(int a, int from, int to, vector<label_front>& pareto,
                                shared_ptr<route> original_route, int k, double qot, unordered_map<int, bool> is_orig_edge,
                                pair<double, double> (*lower_bound_score)(shared_ptr<ParetoElement>, int, int, int, int,
                                                            shared_ptr<route>, int),
-                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>)) {
+                     bool (*prio)(pair<shared_ptr<ParetoElement>, int>, pair<shared_ptr<ParetoElement>, int>),
+                     search_info* info) {
   cout << "Finding pareto routes for " << a << "  using qot  " << qot << endl;
   to_node = to;
   max_sharedA = original_route->a();
@@ -254,14 +1113,27 @@ orig_path = original_route;
   ll visits = 0;
   auto zero_el = make_shared<ParetoElement>();
   q.push({zero_el, a});
+  auto queued_bound = [&](shared_ptr<ParetoElement> par, int u) {
+    return lower_bound_score(par, from, to, a, u, original_route, k).first;
+  };
+  ll labels = 0;
+  double eps = pareto_epsilon;
+  path_marks marks;
   while (!q.empty()) {
+    if (stop_search(q, visits, info, queued_bound))
+      break;
     visits++;
     auto [par, u] = q.top();
     q.pop();
+    count_pops(info);
+    if (simple_paths)
+      marks.mark(*par);
     for (link* l : adj[u]) {
       if (can_ignore(par,l) || (par->hasSplit && !is_orig_edge[l->id]))
         continue;
       int v = l->to;
+      if (revisits(marks, v, info))
+        continue;
       auto newPar = make_shared<ParetoElement>(par, l, is_orig_edge[l->id]);
  
       if (par->hasSplit || (is_orig_edge[l->id] && (par->myLink && !is_orig_edge[par->myLink->id])))
@@ -269,29 +1141,27 @@ orig_path = original_route;
       pair<double, double> ot = lower_bound_score(newPar, from, to, a, v, original_route, k);
 
       if (ot.first > qot + 100) {
+        count_pruned(info, qot);
         continue;
       }
       if (ot.second > 0 && ot.second < qot) {
         cout << "relaxed ot cap" << endl;
         qot = ot.second;
+        note_relaxed(info, ot.second, newPar, a, v);
       }
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.strongly_dominating(vpar, newPar);
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                   return psychological_model.strongly_dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      size_t before = pareto[v].size();
+      bool inserted = insert_label(pareto[v], newPar, true, eps);
+      if (inserted)
         q.push({newPar, v});
-      }
+      labels += static_cast<ll>(pareto[v].size()) - static_cast<ll>(before);
+      count_label(info, inserted, before, pareto[v].size());
     }
+    enforce_label_budget(q, pareto, labels, eps, true, info, queued_bound, from, to, a);
   }
   return make_pair(qot, visits);
 }
 
-ll pareto_dijsktra(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route, 
+ll pareto_dijsktra(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route, 
                      unordered_map<int, bool> inactive,
                      bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)) {
   cout << "Finding pareto routes for " << a << endl;
@@ -318,23 +1188,14 @@ orig_path = original_route;
         continue;
       int v = l->to;
       auto newPar = make_shared<ParetoElement>(par, l);
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.dominating(vpar, newPar);
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                    return psychological_model.dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      if (insert_label(pareto[v], newPar, false, pareto_epsilon))
         q.push({newPar, v});
-      }
     }
   }
   return visits;
 }
 
-ll pareto_dijsktra_4d(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route,
+ll pareto_dijsktra_4d(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route,
                      unordered_map<int, bool> is_orig_edge,
                      bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)) {
   cout << "Finding pareto routes for " << a << endl;
@@ -361,24 +1222,15 @@ orig_path = original_route;
 	  continue;
       int v = l->to;
       auto newPar = make_shared<ParetoElement>(par, l, is_orig_edge[l->id]);
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.strongly_dominating(vpar, newPar);
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                    return psychological_model.strongly_dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      if (insert_label(pareto[v], newPar, true, pareto_epsilon))
         q.push({newPar, v});
-      }
     }
   }
   return visits;
 }
 
 
-void pareto_dijsktra_4d_1D(int a, int b, vector<vector<shared_ptr<ParetoElement>>>& pareto, shared_ptr<route> original_route, 
+void pareto_dijsktra_4d_1D(int a, int b, vector<label_front>& pareto, shared_ptr<route> original_route, 
                      unordered_map<int, bool> is_orig_edge,
                      bool (*prio)(pair<shared_ptr<ParetoElement>, int> left, pair<shared_ptr<ParetoElement>, int> right)) {
   cout << "Finding pareto routes for " << a << endl;
@@ -407,34 +1259,142 @@ orig_path = original_route;
       if (par->hasSplit || (is_orig_edge[l->id] && (par->myLink && !is_orig_edge[par->myLink->id])))
         newPar->hasSplit = true;
       
-      if (!any_of(pareto[v].begin(), pareto[v].end(), [&newPar](shared_ptr<ParetoElement>& vpar) {
-            return psychological_model.strongly_dominating(vpar, newPar);;
-          })) {
-        pareto[v].erase(remove_if(pareto[v].begin(), pareto[v].end(),
-                                  [&newPar](shared_ptr<ParetoElement>& vpar) {
-                                    return psychological_model.strongly_dominating(newPar, vpar);
-                                  }),
-                        pareto[v].end());
-        pareto[v].push_back(newPar);
+      if (insert_label(pareto[v], newPar, true, pareto_epsilon))
         q.push({newPar, v});
-      }
     }
   }
 }
 
-void fill_best_pars_dijkstra(int to, unordered_map<int, bool> inactive) {
-  std::vector<std::vector<link*>> adj_inv(adj.size());
-  for (unsigned int i=0; i<adj.size(); i++) {
-      for (auto link : adj[i])
-        adj_inv[link->to].push_back(link);
+landmarks alt_landmarks;
+
+// selects the ALT landmarks (or loads them from next to the graph) on first use
+void prepare_landmarks() {
+  if (alt_landmarks.size() > 0)
+    return;
+  auto start = chrono::steady_clock::now();
+  auto strat = landmark_strategy == "random" ? landmarks::strategy::random
+                                             : landmarks::strategy::farthest;
+  string path = graphFile + ".alt";
+  uint64_t fingerprint = persist_landmarks ? graph_fingerprint() : 0;
+  if (persist_landmarks && alt_landmarks.load(path, fingerprint, landmark_count, strat)) {
+    cout << "Loaded " << alt_landmarks.size() << " landmarks from " << path << endl;
+  } else {
+    alt_landmarks.select(landmark_count, strat);
+    if (persist_landmarks)
+      alt_landmarks.save(path, fingerprint, landmark_count, strat);
+  }
+  auto end = chrono::steady_clock::now();
+  cout << "ALT preprocessing time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+}
+
+geometric_bounds geometric;
+
+// The ALT bounds are computed on the whole graph; they stay admissible if links are inactive.
+// The CH bounds are exact, the inactive links are taken out by a partial re-customization.
+// Landmarks and hierarchy belong to the full graph, inside a corridor the bounds are searched.
+// The geometric bounds ignore the inactive links as well and need no search at all.
+void compute_bounds(int anchor, bool backward, const unordered_map<int, bool>& inactive,
+                    vector<double>& as, vector<double>& bs) {
+  if (bound_mode == "geometric") {
+    if (!geometric.ready())
+      geometric.prepare();
+    geometric.fill_bounds(anchor, metric::a, as);
+    geometric.fill_bounds(anchor, metric::b, bs);
+    return;
+  }
+  if (bound_mode == "ch" && !od_corridor.active()) {
+    for (auto [m, bound] : {pair{metric::a, &as}, pair{metric::b, &bs}}) {
+      if (inactive.empty())
+        customized(m).one_to_all(anchor, !backward, *bound);
+      else
+        customized(m).without(inactive).one_to_all(anchor, !backward, *bound);
+    }
+    return;
+  }
+  if (bound_mode == "alt" && !od_corridor.active()) {
+    prepare_landmarks();
+    alt_landmarks.fill_bounds(anchor, backward, metric::a, as);
+    alt_landmarks.fill_bounds(anchor, backward, metric::b, bs);
+    return;
+  }
+  one_to_all(anchor, backward ? backward_graph() : forward_graph(),
+             {{metric::b, &bs}, {metric::a, &as}}, inactive);
+}
+
+// The bound arrays of the last bound_cache_size anchors, so that OD groups with the same
+// destination (do_routing schedules them one after the other) reuse them.
+struct cached_bounds {
+  int anchor;
+  bool backward;
+  string mode;
+  uint64_t excluded;  // signature of the inactive links
+  vector<double> as, bs;
+};
+list<cached_bounds> bound_cache;
+
+uint64_t exclusion_signature(const unordered_map<int, bool>& inactive) {
+  vector<int> ids;
+  for (auto& [id, is_inactive] : inactive)
+    if (is_inactive)
+      ids.push_back(id);
+  sort(ids.begin(), ids.end());
+  uint64_t hash = 1469598103934665603ULL;  // FNV-1a
+  for (int id : ids) {
+    hash ^= static_cast<uint64_t>(id);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void fill_bounds(int anchor, bool backward, const unordered_map<int, bool>& inactive,
+                 vector<double>& as, vector<double>& bs) {
+  // ids inside a corridor are local to its OD group
+  if (bound_cache_size <= 0 || od_corridor.active()) {
+    compute_bounds(anchor, backward, inactive, as, bs);
+    return;
+  }
+  uint64_t excluded = exclusion_signature(inactive);
+  for (auto it = bound_cache.begin(); it != bound_cache.end(); it++) {
+    if (it->anchor == anchor && it->backward == backward && it->mode == bound_mode &&
+        it->excluded == excluded) {
+      cout << "Reusing the bounds " << (backward ? "to " : "from ") << anchor << endl;
+      as = it->as;
+      bs = it->bs;
+      bound_cache.splice(bound_cache.begin(), bound_cache, it);
+      return;
     }
-    bestAs = *dijkstra_for_opt(to, true, inactive, adj_inv, false);
-    bestBs = *dijkstra_for_opt(to, false, inactive, adj_inv, false);
+  }
+  compute_bounds(anchor, backward, inactive, as, bs);
+  bound_cache.push_front({anchor, backward, bound_mode, excluded, as, bs});
+  if (static_cast<int>(bound_cache.size()) > bound_cache_size)
+    bound_cache.pop_back();
+}
+
+void fill_best_pars_dijkstra(int to, unordered_map<int, bool> inactive) {
+  fill_bounds(to, true, inactive, bestAs, bestBs);
 }
 
 void fill_best_pars_dijkstra_forward(int from, unordered_map<int, bool> inactive) {
-  bestAsForward = *dijkstra_for_opt(from, true, inactive, adj, true);
-  bestBsForward = *dijkstra_for_opt(from, false, inactive, adj, true);
+  fill_bounds(from, false, inactive, bestAsForward, bestBsForward);
+}
+
+void fill_rejoin_bounds(shared_ptr<route> original_route, const unordered_map<int, bool>& inactive) {
+  // every node of the original route is a source, starting with the rest of the route from there
+  vector<pair<int, vector<double>>> sources;
+  for (size_t j = 0; j <= original_route->links.size(); j++) {
+    int w = j < original_route->links.size() ? original_route->links[j]->from
+                                             : original_route->links.back()->to;
+    sources.push_back({w, {origPartB.back() - origPartB[j], origPartA.back() - origPartA[j]}});
+  }
+  many_to_all(sources, backward_graph(), {{metric::b, &rejoinBs}, {metric::a, &rejoinAs}},
+              inactive);
+}
+
+bool on_original_link(link* l, shared_ptr<route> original_route) {
+  int idx = index_in_original(l->from);
+  return idx >= 0 && idx < static_cast<int>(original_route->links.size()) &&
+         original_route->links[idx] == l;
 }
 
 int index_in_original(int v) {
@@ -455,6 +1415,8 @@ return -1;
 }
 
 void prepare_original_route(shared_ptr<route> original_route, unordered_map<int, bool>& inactive) {
+  // the node ids of the previous OD group may mean other nodes now (in another corridor)
+  nodes_original_route.clear();
   int count = 0;
   nodes_original_route[original_route->links[0]->from] = count++;
   for_each(original_route->links.begin(), original_route->links.end(),
@@ -485,6 +1447,93 @@ double score_for_relax(int idc, int idv, shared_ptr<ParetoElement> par, double k
   return usage > 0 ? score + 10 : -1;
 }
 
+void candidate_batch::push_back(double pa, double pb, double psa, double psb) {
+  a.push_back(pa);
+  b.push_back(pb);
+  shared_a.push_back(psa);
+  shared_b.push_back(psb);
+}
+
+void candidate_batch::score(double aq, double bq, int k) {
+  score(psychological_model, aq, bq, k);
+}
+
+void candidate_batch::score(psychmod& model, double aq, double bq, int k) {
+  size_t n = size();
+  ots.resize(n);
+  usages.resize(n);
+  const size_t block = 1024;
+#pragma omp parallel for schedule(static) if (n > block)
+  for (size_t from = 0; from < n; from += block)
+    model.score_routes(min(block, n - from), &a[from], &b[from], aq, bq, &shared_a[from],
+                       &shared_b[from], k, &ots[from], &usages[from]);
+  if (!check_scores)
+    return;
+  for (size_t i = 0; i < n; i++) {
+    auto [ot, usage] = model.score_route(a[i], b[i], aq, bq, shared_a[i], shared_b[i], k);
+    if (ot != ots[i] || usage != usages[i])
+      cout << "Warning! Batch scoring gone wrong: " << ots[i] << " (" << usages[i]
+           << ") != " << ot << " (" << usage << ")" << endl;
+  }
+}
+
+size_t candidate_batch::best() const {
+  size_t best = size();
+  for (size_t i = 0; i < size(); i++)
+    if (best == size() || ots[i] < ots[best])
+      best = i;
+  return best;
+}
+
+shared_ptr<route> relaxed_route(const search_info& info, shared_ptr<route> original_route) {
+  int idc = is_orig_node(info.relaxed_from, original_route);
+  int idv = is_orig_node(info.relaxed_to, original_route);
+  vector<link*> links(original_route->links.begin(), original_route->links.begin() + max(idc, 0));
+  auto detour = info.relaxed_par->collectLinks();
+  links.insert(links.end(), detour->begin(), detour->end());
+  if (idv >= 0)
+    links.insert(links.end(), original_route->links.begin() + idv, original_route->links.end());
+  return make_shared<route>(links);
+}
+
+pair<shared_ptr<route>, double> best_so_far(const search_info& info, shared_ptr<route> original_route,
+                                            int k, double qot, shared_ptr<route> best,
+                                            double best_ot, double best_usage) {
+  if (info.relaxed_par) {
+    auto relaxed = relaxed_route(info, original_route);
+    unordered_map<int, bool> is_orig_edge;
+    for (link* l : original_route->links)
+      is_orig_edge[l->id] = true;
+    double sa = 0, sb = 0;
+    for (link* l : relaxed->links) {
+      if (is_orig_edge[l->id]) {
+        sa += l->a();
+        sb += l->b();
+      }
+    }
+    auto [ot, usage] = psychological_model.score_route(relaxed->a(), relaxed->b(), original_route->a(),
+                                                       original_route->b(), sa, sb, k);
+    if (usage > 0 && ot < best_ot) {
+      best = relaxed;
+      best_ot = ot;
+      best_usage = usage;
+    }
+  }
+  if (!best || best_ot > qot) {
+    best = original_route;
+    best_ot = qot;
+    best_usage = 0.0;
+  }
+  double lower_bound = min(info.lower_bound, best_ot);
+  cout << "NON-OPTIMAL OT: " << best_ot << " (";
+  if (info.timed_out)
+    cout << "deadline of " << deadline_ms << " ms exceeded, ";
+  if (info.over_budget)
+    cout << "label budget of " << label_budget << " exceeded, ";
+  cout << "lower bound: " << lower_bound << ", gap: " << (best_ot - lower_bound) / best_ot << ")"
+       << endl;
+  return {best, best_usage};
+}
 
 void check_route_sanity(route& r, string routeName) {
   int last_node = r.links[0]->from;
@@ -21,15 +21,20 @@
 #include "core/globals.h"
 #include "core/routing.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 
 using namespace std;
 
 
 void route(int source, int destination, vector<int> pids) {
+  begin_query("dijkstra", source, destination, pids.size());
   auto start = chrono::steady_clock::now();
   auto original_route = dijkstra(source, destination);
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.search_us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+  end_query(original_route, original_route, 0.0);
   cout << "Length original: " << original_route->links.size() << endl;
     cout << "K: " << pids.size() << endl;
   auto score = pids.size() * psychological_model.latency(original_route->a(), original_route->b(), pids.size());
@@ -43,6 +48,7 @@ void route(int source, int destination, vector<int> pids) {
 void do_routing(int argc, char* argv[]) {
     (void) argc;
     (void) argv;
+  parse_ssotd_env();
 
   map<pair<pair<int, int>, string>, vector<int>> c;
   for (unsigned int pid = 0; pid < persons.size(); pid++) {
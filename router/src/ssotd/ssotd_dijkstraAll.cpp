@@ -22,6 +22,9 @@
 #include "core/globals.h"
 #include "core/routing.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 
 using namespace std;
 
@@ -30,6 +33,15 @@ using minq = priority_queue<T, vector<T>, greater<>>;
 
 
 shared_ptr<route> dijkstra_all(int a, int b, int k) {
+  if (use_ch) {
+    auto r = customized(metric::taud, k).query(a, b);
+    if (!r || r->links.empty()) {
+      cerr << "WARNING!" << endl;
+      cerr << "(djikstra) could not find any route from " << a << " to " << b << endl;
+      exit(1);
+    }
+    return r;
+  }
   vector<double> dist(adj.size(), HUGE_VAL);
   vector<pair<int, link*>> prec(adj.size(), {-1, nullptr});
   minq<pair<double, int>> q;
@@ -69,10 +81,13 @@ shared_ptr<route> dijkstra_all(int a, int b, int k) {
 }
 
 void route(int source, int destination, vector<int> pids) {
+  begin_query("dijkstraAll", source, destination, pids.size());
   auto start = chrono::steady_clock::now();
   auto original_route = dijkstra_all(source, destination, pids.size());
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.search_us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+  end_query(original_route, original_route, 0.0);
   cout << "Length original: " << original_route->links.size() << endl;
     cout << "K: " << pids.size() << endl;
   auto score = pids.size() * psychological_model.latency(original_route->a(), original_route->b(), pids.size());
@@ -86,6 +101,7 @@ void route(int source, int destination, vector<int> pids) {
 void do_routing(int argc, char* argv[]) {
     (void) argc;
     (void) argv;
+  parse_ssotd_env();
 
   map<pair<pair<int, int>, string>, vector<int>> c;
   for (unsigned int pid = 0; pid < persons.size(); pid++) {
@@ -13,6 +13,7 @@
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <omp.h>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -20,25 +21,237 @@
 #include "core/data.h"
 #include "core/globals.h"
 #include "core/routing.h"
+#include "ssotd/ssotd_cache.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 
 using namespace std;
+using ll = long long;
 
 //This file refers to the D-SAP algorithm
 
+// The models of SSOTD_MODELS, whose best alternatives are taken from the same Pareto set. All of
+// them share the dominance criteria of the 2r models, so the set only has to keep every label
+// that one of them could still use.
+vector<unique_ptr<psychmod>> extra_models;
+
+// What a search serves if it is not only the built model at the k of the search: every model at
+// every agent count (the k of the search, or those of SSOTD_K_SWEEP), each with its own OT cap. A
+// label is pruned only if its bound exceeds every one of these caps, so the bound handed to the
+// search is its smallest excess over a cap plus the cap of the search (search_cap). Complete
+// alternatives lower the caps they beat instead of the cap of the search (not in parallel).
+struct served_cap {
+  psychmod* model;
+  int count;
+  double cap;
+};
+vector<served_cap> served;
+double search_cap;
+
+// fills served for the counts and returns the cap of the search, the highest one
+double serve(const vector<int>& counts, shared_ptr<route> original_route) {
+  served.clear();
+  search_cap = 0;
+  auto add = [&](psychmod& model) {
+    for (int count : counts) {
+      double cap = count * model.latency(original_route->a(), original_route->b(), count);
+      served.push_back({&model, count, cap});
+      search_cap = max(search_cap, cap);
+    }
+  };
+  add(psychological_model);
+  for (auto& model : extra_models)
+    add(*model);
+  return search_cap;
+}
+
+// the bound of a path to v with parameters pa and pb for the built model, its score if v == to
+pair<double, double> target_bound(double pa, double pb, int to, int v, shared_ptr<route> original_route,
+                                  int k) {
+  auto score = psychological_model.score_route(pa + bestAs[v], pb + bestBs[v], original_route->a(), original_route->b(), 0 , 0, k);
+  if (score.second > 0)
+    return make_pair(score.first, to == v ? score.first : -1);
+  return make_pair(HUGE_VAL, -1);
+}
+
 pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, int from, int to, int c, int v,
                                   shared_ptr<route> original_route, int k) {
   (void) from; (void) c;
-  auto score = psychological_model.score_route(par->a() + bestAs[v], par->b() + bestBs[v], original_route->a(), original_route->b(), 0 , 0, k);
-  if (score.second > 0)
-    return make_pair(score.first, to == v ? score.first : -1);
+  if (served.empty())
+    return target_bound(par->a(), par->b(), to, v, original_route, k);
+  double excess = HUGE_VAL;
+  for (auto& s : served) {
+    auto score = s.model->score_route(par->a() + bestAs[v], par->b() + bestBs[v], original_route->a(), original_route->b(), 0 , 0, s.count);
+    if (score.second <= 0)
+      continue;
+    if (to == v && score.first < s.cap && omp_get_level() == 0)
+      s.cap = score.first;
+    excess = min(excess, score.first - s.cap);
+  }
+  if (excess < HUGE_VAL)
+    return make_pair(search_cap + excess, -1);
   return make_pair(HUGE_VAL, -1);
 }
 
+// The alternative of the batch a search for a single model and count would select: the one with
+// the lowest OT among those with a usage (the search prunes the others), size() if there is none.
+size_t best_used(const candidate_batch& batch) {
+  size_t best = batch.size();
+  for (size_t i = 0; i < batch.size(); i++)
+    if (batch.usages[i] > 0 && (best == batch.size() || batch.ots[i] < batch.ots[best]))
+      best = i;
+  return best;
+}
+
+// the best alternative of the Pareto set under each model of SSOTD_MODELS
+void print_extra_models(label_front& front, shared_ptr<route> original_route, int k) {
+  candidate_batch batch;
+  for (auto& par : front)
+    batch.push_back(par->a(), par->b(), 0, 0);
+  for (size_t m = 0; m < extra_models.size(); m++) {
+    auto& model = *extra_models[m];
+    batch.score(model, original_route->a(), original_route->b(), k);
+    double qot = k * model.latency(original_route->a(), original_route->b(), k);
+    size_t best = best_used(batch);
+    cout << "Model " << evaluation_models[m] << ": ";
+    if (best == batch.size() || batch.ots[best] > qot) {
+      cout << "original route, OT " << qot << endl;
+      continue;
+    }
+    cout << "OT " << batch.ots[best] << " usage " << batch.usages[best]
+         << " a: " << front[best]->a() << "  b: " << front[best]->b() << endl;
+  }
+}
+
+// the OD groups whose Pareto set at the destination the parallel search and the sequential one
+// agree on (SSOTD_PARALLEL_CHECK)
+struct parallel_check_count {
+  ll groups = 0, mismatches = 0;
+};
+parallel_check_count parallel_checks;
+
+// runs the sequential search as well and compares its Pareto set at b to front, label by label
+void check_parallel_front(int a, int b, label_front& front, shared_ptr<route> original_route,
+                          int k, double qot, unordered_map<int, bool>& inactive) {
+  vector<label_front> pareto(adj.size());
+  search_info info;
+  pareto_dijkstra_local_opt(a, a, b, pareto, original_route, k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, &info);
+  auto same = [](const shared_ptr<ParetoElement>& left, const shared_ptr<ParetoElement>& right) {
+    return *left->collectLinks() == *right->collectLinks();
+  };
+  bool match = equal(front.begin(), front.end(), pareto[b].begin(), pareto[b].end(), same);
+  parallel_checks.groups++;
+  if (!match)
+    parallel_checks.mismatches++;
+  cout << "Parallel search check: " << front.size() << " labels at the destination, "
+       << pareto[b].size() << " sequentially, " << (match ? "same" : "DIFFERENT") << endl;
+}
+
+// The best alternative known before the search (SSOTD_SEED_BOUND). The search could find it as
+// well, so its OT caps the search from the start instead of the OT of the original route. Labels
+// that are no better are pruned, hence the search may return nothing better than the seed.
+// Without a seed, r is null and ot HUGE_VAL.
+struct seed_alternative {
+  shared_ptr<route> r;
+  double ot = HUGE_VAL;
+  double usage = 0.0;
+};
+
+// The better one of two routes that avoid the original route: the disjoint Dijkstra route (the
+// checkup of ssotd), and the one with the lowest latency at k / 2 agents. The latter takes the
+// congestion of the alternative into account and tends to be close to the optimum. A route that
+// is not better than the original route (OT qot) is no seed, as the search would not return it.
+seed_alternative make_seed(int a, int b, shared_ptr<route> route_dijk,
+                           shared_ptr<route> original_route, int k, double qot) {
+  seed_alternative seed;
+  if (!seed_bound || !extra_models.empty())
+    return seed;
+  for (auto& r : {route_dijk, latency_dijkstra(a, b, original_route, k / 2.0)}) {
+    auto score = psychological_model.score_route(r->a(), r->b(), original_route->a(), original_route->b(), 0 , 0, k);
+    if (score.second > 0 && score.first < qot && score.first < seed.ot)
+      seed = {r, score.first, static_cast<double>(score.second)};
+  }
+  return seed;
+}
+
+void print_visits(long long visits, const seed_alternative& seed) {
+  cout << "Node visits: " << visits;
+  if (seed.r)
+    cout << " (cap seeded with OT " << seed.ot << ")";
+  cout << endl;
+}
+
+// the result if the seed beats every alternative the search found
+pair<shared_ptr<route>, double> seed_result(const search_info& info, shared_ptr<route> original_route,
+                                            int k, double qot, const seed_alternative& seed) {
+  cout << "BEST PARETO OT: " << seed.ot << " (seed)" << endl;
+  if (!info.exhaustive())
+    return best_so_far(info, original_route, k, qot, seed.r, seed.ot, seed.usage);
+  if (seed.ot > qot)
+    return {original_route, 0.0};
+  cout << "a: " << seed.r->a() << "  b: " << seed.r->b() << endl;
+  return {seed.r, seed.usage};
+}
+
+// Same as the search in ssotd_route, but from both ends at once (SSOTD_BIDIRECTIONAL)
+pair<shared_ptr<route>, double> ssotd_route_bidirectional(int a, int b,
+                                                          shared_ptr<route> original_route, int k,
+                                                          double qot,
+                                                          unordered_map<int, bool>& inactive,
+                                                          const seed_alternative& seed) {
+  auto start = chrono::steady_clock::now();
+  fill_best_pars_dijkstra_forward(a);
+  auto end = chrono::steady_clock::now();
+  current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  cout << "Forward precalculation time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  start = chrono::steady_clock::now();
+  search_info info;
+  bidirectional_result res =
+      pareto_dijkstra_bidirectional(a, b, original_route, k, min(qot, seed.ot), inactive, &info);
+  end = chrono::steady_clock::now();
+  cout << "Node visits: " << res.forward_visits + res.backward_visits << " (forward "
+       << res.forward_visits << ", backward " << res.backward_visits;
+  if (seed.r)
+    cout << ", cap seeded with OT " << seed.ot;
+  cout << ")" << endl;
+  cout << "Labels: " << res.forward_labels + res.backward_labels << " (forward "
+       << res.forward_labels << ", backward " << res.backward_labels << ")" << endl;
+  cout << "Meeting candidates: " << res.meetings;
+  if (res.stopped_early)
+    cout << " (stopped on the bound of both directions)";
+  cout << endl;
+  print_pruned(info);
+  cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.search_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  current_query.visits += res.forward_visits + res.backward_visits;
+  current_query.search.merge(info);
+
+  if (seed.ot < res.ot)
+    return seed_result(info, original_route, k, qot, seed);
+  if (!res.forward) {
+    cout << "Found no useful pareto-routes." << endl;
+    if (!info.exhaustive())
+      return best_so_far(info, original_route, k, qot, nullptr, HUGE_VAL, 0.0);
+    return {original_route, 0.0};
+  }
+  cout << "BEST PARETO OT: " << res.ot << endl;
+  auto best = res.collectRoute();
+  if (!info.exhaustive())
+    return best_so_far(info, original_route, k, qot, best, res.ot, res.usage);
+  if (res.ot > qot)
+    return {original_route, 0.0};
+
+  cout << "a: " << best->a() << "  b: " << best->b() << endl;
+  return {best, res.usage};
+}
+
 pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> original_route, int k,
-                                            string optimization) {
+                                            string optimization, shared_ptr<route> route_dijk) {
   (void)optimization;
-  vector<vector<shared_ptr<ParetoElement>>> pareto(adj.size());
+  vector<label_front> pareto(adj.size());
   unordered_map<int, bool> inactive;
   for_each(original_route->links.begin(), original_route->links.end(),
            [&inactive](link* l) { inactive[l->id] = true; });
@@ -46,29 +259,81 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 
   double qot = k * psychological_model.latency(original_route->a(), original_route->b(), k);
   std::cout << "DIJKSTRA OT: " << qot << std::endl;
-  cout << "Doing dijkstra-astar optimization" << endl;
+  seed_alternative seed = make_seed(a, b, route_dijk, original_route, k, qot);
+  bool bidirectional = bidirectional_search && extra_models.empty();
+  front_cache_slot cache("fulldisjoint", a, b, k, *original_route);
+  front_map cached;
+  search_info info;
   auto start = chrono::steady_clock::now();
-  fill_best_pars_dijkstra(b);
-  auto end = chrono::steady_clock::now();
-  cout << "Route specific precalculation time: "
-        << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
-  start = chrono::steady_clock::now();
-  auto [bound, visits] = pareto_dijkstra_local_opt(a, a, b, pareto, original_route, k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra);
-  (void) bound;
-  end = chrono::steady_clock::now();
-  cout << "Node visits: " << visits << endl;
-  cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
-  
+  auto end = start;
+  if (!bidirectional && cache.load(cached)) {
+    for (auto& par : cached[{a, b}])
+      pareto[b].push_back(par);
+  } else {
+    double search_qot = extra_models.empty() ? min(qot, seed.ot) : serve({k}, original_route);
+    cout << "Doing dijkstra-astar optimization" << endl;
+    start = chrono::steady_clock::now();
+    fill_best_pars_dijkstra(b);
+    end = chrono::steady_clock::now();
+    current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    cout << "Route specific precalculation time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    if (bidirectional)
+      return ssotd_route_bidirectional(a, b, original_route, k, qot, inactive, seed);
+    start = chrono::steady_clock::now();
+    bool compact = compact_labels && extra_models.empty() && !parallel_search;
+    compact_search compact_run;
+    auto [bound, visits] =
+        compact
+            ? pareto_dijkstra_compact(a, b, compact_run, original_route, k, search_qot, inactive, &target_bound, &info)
+        : parallel_search
+            ? pareto_dijkstra_parallel(a, a, b, pareto, original_route, k, search_qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, !served.empty(), &info)
+            : pareto_dijkstra_local_opt(a, a, b, pareto, original_route, k, search_qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, &info);
+    (void) bound;
+    served.clear();
+    end = chrono::steady_clock::now();
+    print_visits(visits, seed);
+    print_pruned(info);
+    cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    current_query.search_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    current_query.visits += visits;
+    current_query.search.merge(info);
+    if (parallel_search && parallel_check) {
+      double check_qot = extra_models.empty() ? min(qot, seed.ot) : serve({k}, original_route);
+      check_parallel_front(a, b, pareto[b], original_route, k, check_qot, inactive);
+      served.clear();
+    }
+    if (compact)
+      add_front_sizes(compact_run.pareto);
+    else
+      add_front_sizes(pareto);
+
+    int mycounter = 0;
+    ll labels = 0;
+    for (size_t i=0; i < nodes.size(); i++) {
+      size_t size = compact ? compact_run.pareto[i].size() : pareto[i].size();
+      if (size > 0)
+        mycounter++;
+      labels += size;
+    }
+    cout << "Visited " << mycounter << " nodes" << endl;
+    cout << "Labels: " << labels << endl;
+    if (compact)
+      for (uint32_t i : compact_run.pareto[b])
+        pareto[b].push_back(compact_run.materialize(i));
+    if (info.exhaustive())
+      cache.store({{{a, b}, pareto[b]}});
+  }
+
+  print_extra_models(pareto[b], original_route, k);
+  if (pareto[b].empty() && seed.r)
+    return seed_result(info, original_route, k, qot, seed);
   if (pareto[b].empty()) {
     cout << "Found no useful pareto-routes." << endl;
+    if (!info.exhaustive())
+      return best_so_far(info, original_route, k, qot, nullptr, HUGE_VAL, 0.0);
     return {original_route, 0.0};
   }
-  int mycounter = 0;
-  for (size_t i=0; i < nodes.size(); i++) {
-    if (pareto[i].size() > 0)
-      mycounter++;
-  }
-  cout << "Visited " << mycounter << " nodes" << endl;
   cout << "Found " << pareto[b].size() << " pareto-optimal routes" << endl;
   cout << "Mean Pareto-set size: " << pareto[b].size() << endl;
   cout << "Sum Pareto-set size: " << pareto[b].size() << endl;
@@ -76,20 +341,31 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 
   start = chrono::steady_clock::now();
   
-  pair<double, int> score, best_score = {HUGE_VAL, 0};
+  pair<double, int> best_score = {HUGE_VAL, 0};
   auto best_elem = pareto[b].begin();
-  for (auto current_elem = pareto[b].begin(); current_elem != pareto[b].end(); current_elem++) {
-    score = psychological_model.score_route((*current_elem)->a(), (*current_elem)->b(), original_route->a(), original_route->b(), 0 , 0, k);
-    if (best_score.first > score.first) {
-      best_score = score;
-      best_elem = current_elem;
-    }
+  candidate_batch batch;
+  for (auto& par : pareto[b])
+    batch.push_back(par->a(), par->b(), 0, 0);
+  batch.score(original_route->a(), original_route->b(), k);
+  if (size_t best = batch.best(); best < batch.size()) {
+    best_score = {batch.ots[best], batch.usages[best]};
+    best_elem += best;
   }
     end = chrono::steady_clock::now();
     cout << "Evaluation time: "
          << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.evaluation_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  current_query.pareto_set += pareto[b].size();
 
-  cout << "BEST PARETO OT: " << best_score.first << endl;
+  if (seed.ot < best_score.first)
+    return seed_result(info, original_route, k, qot, seed);
+  cout << "BEST PARETO OT: " << best_score.first;
+  if (pareto_epsilon > 0 || info.over_budget)
+    cout << " (epsilon bound: " << approximation_bound(pareto[b]) << ")";
+  cout << endl;
+  if (!info.exhaustive())
+    return best_so_far(info, original_route, k, qot, (*best_elem)->collectRoute(), best_score.first,
+                       best_score.second);
   if (best_score.first > qot)
     return {original_route, 0.0};
 
@@ -98,7 +374,72 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   return {res, best_score.second};
 }
 
+// Solves the OD for every agent count of SSOTD_K_SWEEP with one search and prints the best OT and
+// usage per count. The search runs at the largest count. A label is dropped only if another one
+// has a lower b and a lower taud at that count; as the taud of a path is a * count^2 + b, the
+// other one then has the lower taud at every smaller count, too. The original route, the bounds
+// and the prefix sums do not depend on the count at all. The latencies the links have cached are
+// restored afterwards, so the sweep does not change the routes of later OD groups.
+void ssotd_k_sweep(int a, int b, shared_ptr<route> original_route) {
+  int max_k = *max_element(k_sweep.begin(), k_sweep.end());
+  unordered_map<int, bool> inactive;
+  for (link* l : original_route->links)
+    inactive[l->id] = true;
+  auto cap = [&](psychmod& model, int count) {
+    return count * model.latency(original_route->a(), original_route->b(), count);
+  };
+
+  auto start = chrono::steady_clock::now();
+  // the bounds of ssotd_route (from the bound cache), they hold for every count
+  fill_best_pars_dijkstra(b);
+  vector<label_front> pareto(adj.size());
+  search_info info;
+  ll visits;
+  {
+    agent_count_scope count(max_k);
+    double qot = serve(k_sweep, original_route);
+    visits =
+        parallel_search
+            ? pareto_dijkstra_parallel(a, a, b, pareto, original_route, max_k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, !served.empty(), &info).second
+            : pareto_dijkstra_local_opt(a, a, b, pareto, original_route, max_k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, &info).second;
+    served.clear();
+  }
+  auto end = chrono::steady_clock::now();
+  cout << "K sweep: " << visits << " node visits, " << pareto[b].size()
+       << " labels at the destination, time used: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  if (!info.exhaustive())
+    cout << "K sweep was cut short, its OTs are NON-OPTIMAL" << endl;
+
+  // the original route (usage 0) wherever no alternative beats it, like ssotd_route
+  candidate_batch batch;
+  for (auto& par : pareto[b])
+    batch.push_back(par->a(), par->b(), 0, 0);
+  auto print_best = [&](psychmod& model, int count) {
+    batch.score(model, original_route->a(), original_route->b(), count);
+    size_t best = best_used(batch);
+    if (best == batch.size() || batch.ots[best] > cap(model, count))
+      cout << "\t" << cap(model, count) << "\t0";
+    else
+      cout << "\t" << batch.ots[best] << "\t" << batch.usages[best];
+  };
+  cout << "k\tOT\tusage";
+  for (auto& name : evaluation_models)
+    cout << "\t" << name << " OT\tusage";
+  cout << endl;
+  for (int count : k_sweep) {
+    cout << count;
+    print_best(psychological_model, count);
+    for (auto& model : extra_models)
+      print_best(*model, count);
+    cout << endl;
+  }
+}
+
 void ssotd(int source, int destination, vector<int> pids, string optimization) {
+  start_deadline();
+  begin_query("fulldisjoint", source, destination, pids.size());
+  enter_od_corridor(source, destination);
   shared_ptr<route> original_route = dijkstra(source, destination);
     cout << "Length original: " << original_route->links.size() << endl;
     cout << "d: " << pids.size() << endl;
@@ -109,9 +450,10 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
 
   auto start = chrono::steady_clock::now();
   pair<shared_ptr<route>, double> ssotd_res =
-      ssotd_route(source, destination, original_route, pids.size(), optimization);
+      ssotd_route(source, destination, original_route, pids.size(), optimization, route_dijk);
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  end_query(ssotd_res.first, original_route, ssotd_res.second);
   double usage = ssotd_res.second / static_cast<double>(pids.size());
   cout << "normalized usage of the pareto route: " << usage << endl;
   for (int pid : pids)
@@ -119,6 +461,9 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       persons[pid].r = ssotd_res.first;
     else
       persons[pid].r = original_route;
+  if (!k_sweep.empty())
+    ssotd_k_sweep(source, destination, original_route);
+  leave_od_corridor(pids);
 }
 
 void do_routing(int argc, char* argv[]) {
@@ -131,16 +476,24 @@ void do_routing(int argc, char* argv[]) {
     optimization = optimization.substr(pos1, pos2 - pos1 + 1);
   } else
     optimization = "none";
+  parse_ssotd_env();
+  for (auto& name : evaluation_models)
+    extra_models.push_back(make_psychmod(name));
+  if (bidirectional_search && !extra_models.empty())
+    cout << "SSOTD_MODELS needs the unidirectional search, ignoring SSOTD_BIDIRECTIONAL" << endl;
+  if (compact_labels && (!extra_models.empty() || parallel_search))
+    cout << "SSOTD_COMPACT_LABELS needs the sequential search for one model, ignoring it" << endl;
+  else if (compact_labels && (pareto_epsilon > 0 || label_budget > 0))
+    cout << "SSOTD_COMPACT_LABELS uses exact dominance, ignoring SSOTD_EPSILON and "
+            "SSOTD_LABEL_BUDGET" << endl;
 
-  map<pair<pair<int, int>, string>, vector<int>> c;
-  for (unsigned int pid = 0; pid < persons.size(); pid++) {
-    auto& p = persons[pid];
-    string s = p.timestr;  // maybe
-    c[{{p.origin, p.destination}, s}].push_back(pid);
-  }
   // do ssotd for all
-  for (auto& [sdts, pv] : c) {
-    number_agents = pv.size();
-    ssotd(sdts.first.first, sdts.first.second, pv, optimization);
+  for (auto& group : od_groups()) {
+    number_agents = group.pids.size();
+    ssotd(group.origin, group.destination, group.pids, optimization);
   }
+  print_front_cache_stats();
+  if (parallel_checks.groups > 0)
+    cout << "Parallel search check over " << parallel_checks.groups << " OD groups: "
+         << parallel_checks.mismatches << " with a different Pareto set" << endl;
 }
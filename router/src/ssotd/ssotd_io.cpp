@@ -0,0 +1,346 @@
+#include "ssotd/ssotd_io.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/corridor.h"
+#include "core/psychmod.h"
+#include "ssotd/ssotd_defaults.h"
+#include "ssotd/ssotd_globals.h"
+
+double pareto_epsilon;
+long long deadline_ms;
+long long label_budget;
+std::string bound_mode;
+int landmark_count;
+std::string landmark_strategy;
+bool persist_landmarks;
+bool use_ch;
+bool persist_ch;
+std::string corridor_kind;
+double corridor_slack;
+int bound_cache_size;
+bool bidirectional_search;
+bool seed_bound;
+bool simple_paths;
+bool parallel_search;
+bool parallel_check;
+bool compact_labels;
+bool via_exact;
+bool check_scores;
+std::vector<std::string> evaluation_models;
+std::vector<int> k_sweep;
+std::string front_cache_dir;
+long long front_cache_mb;
+std::string stats_sink;
+std::string stats_format;
+
+void parse_ssotd_env() {
+  std::cout << "Parsing the environment." << std::endl;
+  char* eps_env = getenv("SSOTD_EPSILON");
+  if (eps_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_EPSILON (approximate Pareto sets)"
+              << std::endl;
+    pareto_epsilon = default_pareto_epsilon;
+  } else {
+    pareto_epsilon = std::strtod(eps_env, nullptr);
+  }
+  if (pareto_epsilon < 0) {
+    std::cerr << "SSOTD_EPSILON has to be non-negative, using exact dominance." << std::endl;
+    pareto_epsilon = 0;
+  }
+  if (pareto_epsilon > 0)
+    std::cout << "Using epsilon-dominance with epsilon " << pareto_epsilon << std::endl;
+
+  char* deadline_env = getenv("SSOTD_DEADLINE_MS");
+  if (deadline_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_DEADLINE_MS (time budget per OD group)"
+              << std::endl;
+    deadline_ms = default_deadline_ms;
+  } else {
+    deadline_ms = std::strtoll(deadline_env, nullptr, 10);
+  }
+  if (deadline_ms < 0) {
+    std::cerr << "SSOTD_DEADLINE_MS has to be non-negative, using no deadline." << std::endl;
+    deadline_ms = 0;
+  }
+  if (deadline_ms > 0)
+    std::cout << "Using a deadline of " << deadline_ms << " ms per OD group" << std::endl;
+
+  char* budget_env = getenv("SSOTD_LABEL_BUDGET");
+  if (budget_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_LABEL_BUDGET (max. labels per search)"
+              << std::endl;
+    label_budget = default_label_budget;
+  } else {
+    label_budget = std::strtoll(budget_env, nullptr, 10);
+  }
+  if (label_budget < 0) {
+    std::cerr << "SSOTD_LABEL_BUDGET has to be non-negative, using no budget." << std::endl;
+    label_budget = 0;
+  }
+  if (label_budget > 0)
+    std::cout << "Using a budget of " << label_budget << " labels per search" << std::endl;
+
+  char* bounds_env = getenv("SSOTD_BOUNDS");
+  if (bounds_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_BOUNDS (dijkstra, alt, ch or geometric)"
+              << std::endl;
+    bound_mode = default_bounds;
+  } else {
+    bound_mode = std::string(bounds_env);
+  }
+  if (bound_mode != "dijkstra" && bound_mode != "alt" && bound_mode != "ch" &&
+      bound_mode != "geometric") {
+    std::cerr << "Unknown SSOTD_BOUNDS " << bound_mode << ", using " << default_bounds << std::endl;
+    bound_mode = default_bounds;
+  }
+
+  char* landmarks_env = getenv("SSOTD_LANDMARKS");
+  if (landmarks_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_LANDMARKS" << std::endl;
+    landmark_count = default_landmarks;
+  } else {
+    landmark_count = static_cast<int>(std::strtol(landmarks_env, nullptr, 0));
+  }
+  if (landmark_count < 1) {
+    std::cerr << "SSOTD_LANDMARKS has to be positive, using " << default_landmarks << std::endl;
+    landmark_count = default_landmarks;
+  }
+
+  char* strategy_env = getenv("SSOTD_LANDMARK_STRATEGY");
+  if (strategy_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_LANDMARK_STRATEGY (farthest or random)"
+              << std::endl;
+    landmark_strategy = default_landmark_strategy;
+  } else {
+    landmark_strategy = std::string(strategy_env);
+  }
+  if (landmark_strategy != "farthest" && landmark_strategy != "random") {
+    std::cerr << "Unknown SSOTD_LANDMARK_STRATEGY " << landmark_strategy << ", using "
+              << default_landmark_strategy << std::endl;
+    landmark_strategy = default_landmark_strategy;
+  }
+
+  char* persist_env = getenv("SSOTD_LANDMARK_PERSIST");
+  if (persist_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_LANDMARK_PERSIST (1 to store the ALT "
+                 "tables next to the graph)"
+              << std::endl;
+    persist_landmarks = false;
+  } else {
+    persist_landmarks = std::strtol(persist_env, nullptr, 0) != 0;
+  }
+  char* cache_env = getenv("SSOTD_BOUND_CACHE");
+  if (cache_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_BOUND_CACHE (bound arrays kept for "
+                 "OD groups with the same destination, 0 to disable)"
+              << std::endl;
+    bound_cache_size = default_bound_cache;
+  } else {
+    bound_cache_size = static_cast<int>(std::strtol(cache_env, nullptr, 0));
+  }
+
+  if (bound_mode == "alt")
+    std::cout << "Using ALT bounds with " << landmark_count << " " << landmark_strategy
+              << " landmarks" << std::endl;
+
+  char* ch_env = getenv("SSOTD_CH");
+  if (ch_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_CH (1 to answer the single-criterion "
+                 "Dijkstras with a contraction hierarchy)"
+              << std::endl;
+    use_ch = false;
+  } else {
+    use_ch = std::strtol(ch_env, nullptr, 0) != 0;
+  }
+
+  char* ch_persist_env = getenv("SSOTD_CH_PERSIST");
+  if (ch_persist_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_CH_PERSIST (1 to store the contraction "
+                 "hierarchy next to the graph)"
+              << std::endl;
+    persist_ch = false;
+  } else {
+    persist_ch = std::strtol(ch_persist_env, nullptr, 0) != 0;
+  }
+  if (use_ch || bound_mode == "ch")
+    std::cout << "Using a contraction hierarchy" << std::endl;
+
+  parse_corridor_env("SSOTD", default_corridor, default_corridor_slack, corridor_kind,
+                     corridor_slack);
+
+  char* bidirectional_env = getenv("SSOTD_BIDIRECTIONAL");
+  if (bidirectional_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_BIDIRECTIONAL (1 to search from both ends "
+                 "in the fulldisjoint variant)"
+              << std::endl;
+    bidirectional_search = false;
+  } else {
+    bidirectional_search = std::strtol(bidirectional_env, nullptr, 0) != 0;
+  }
+
+  char* seed_env = getenv("SSOTD_SEED_BOUND");
+  if (seed_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_SEED_BOUND (0 to start the fulldisjoint "
+                 "search without the OT of the disjoint Dijkstra route as its cap)"
+              << std::endl;
+    seed_bound = default_seed_bound;
+  } else {
+    seed_bound = std::strtol(seed_env, nullptr, 0) != 0;
+  }
+
+  char* simple_env = getenv("SSOTD_SIMPLE_PATHS");
+  if (simple_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_SIMPLE_PATHS (1 to reject labels whose "
+                 "path revisits a node)"
+              << std::endl;
+    simple_paths = false;
+  } else {
+    simple_paths = std::strtol(simple_env, nullptr, 0) != 0;
+  }
+
+  char* parallel_env = getenv("SSOTD_PARALLEL_SEARCH");
+  if (parallel_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_PARALLEL_SEARCH (1 to run the Pareto "
+                 "search of fulldisjoint on all OpenMP threads)"
+              << std::endl;
+    parallel_search = false;
+  } else {
+    parallel_search = std::strtol(parallel_env, nullptr, 0) != 0;
+  }
+
+  char* parallel_check_env = getenv("SSOTD_PARALLEL_CHECK");
+  if (parallel_check_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_PARALLEL_CHECK (1 to compare the Pareto "
+                 "sets of the parallel search to those of the sequential one)"
+              << std::endl;
+    parallel_check = false;
+  } else {
+    parallel_check = std::strtol(parallel_check_env, nullptr, 0) != 0;
+  }
+
+  char* compact_env = getenv("SSOTD_COMPACT_LABELS");
+  if (compact_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_COMPACT_LABELS (1 to keep the labels of "
+                 "the fulldisjoint search as floats, in a third of the memory)"
+              << std::endl;
+    compact_labels = false;
+  } else {
+    compact_labels = std::strtol(compact_env, nullptr, 0) != 0;
+  }
+
+  char* via_exact_env = getenv("SSOTD_VIA_EXACT");
+  if (via_exact_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_VIA_EXACT (1 to compare the via variant "
+                 "to the exact fulldisjoint search)"
+              << std::endl;
+    via_exact = false;
+  } else {
+    via_exact = std::strtol(via_exact_env, nullptr, 0) != 0;
+  }
+
+  char* check_env = getenv("SSOTD_CHECK_SCORES");
+  if (check_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_CHECK_SCORES (1 to compare the batch "
+                 "scores of the alternatives to those of score_route)"
+              << std::endl;
+    check_scores = false;
+  } else {
+    check_scores = std::strtol(check_env, nullptr, 0) != 0;
+  }
+
+  char* models_env = getenv("SSOTD_MODELS");
+  evaluation_models.clear();
+  if (models_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_MODELS (comma separated psychological "
+                 "models to score the fulldisjoint Pareto set under, besides the built one)"
+              << std::endl;
+  } else {
+    std::istringstream models(models_env);
+    std::string model;
+    while (std::getline(models, model, ',')) {
+      if (model.empty())
+        continue;
+      if (make_psychmod(model))
+        evaluation_models.push_back(model);
+      else
+        std::cerr << "Unknown model " << model << " in SSOTD_MODELS, ignoring it" << std::endl;
+    }
+  }
+
+  char* sweep_env = getenv("SSOTD_K_SWEEP");
+  k_sweep.clear();
+  if (sweep_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_K_SWEEP (comma separated agent counts to "
+                 "solve every fulldisjoint OD for)"
+              << std::endl;
+  } else {
+    std::istringstream counts(sweep_env);
+    std::string count;
+    while (std::getline(counts, count, ',')) {
+      int k = std::strtol(count.c_str(), nullptr, 0);
+      if (k > 0)
+        k_sweep.push_back(k);
+      else if (!count.empty())
+        std::cerr << "Invalid agent count " << count << " in SSOTD_K_SWEEP, ignoring it"
+                  << std::endl;
+    }
+  }
+
+  char* front_cache_env = getenv("SSOTD_FRONT_CACHE");
+  if (front_cache_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_FRONT_CACHE (directory to keep the Pareto "
+                 "fronts of the OD groups in for later runs)"
+              << std::endl;
+    front_cache_dir.clear();
+  } else {
+    front_cache_dir = std::string(front_cache_env);
+  }
+
+  char* front_cache_mb_env = getenv("SSOTD_FRONT_CACHE_MB");
+  if (front_cache_mb_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_FRONT_CACHE_MB" << std::endl;
+    front_cache_mb = default_front_cache_mb;
+  } else {
+    front_cache_mb = std::strtoll(front_cache_mb_env, nullptr, 10);
+  }
+  if (front_cache_mb <= 0) {
+    std::cerr << "SSOTD_FRONT_CACHE_MB has to be positive, using " << default_front_cache_mb
+              << std::endl;
+    front_cache_mb = default_front_cache_mb;
+  }
+  char* stats_env = getenv("SSOTD_STATS");
+  if (stats_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_STATS (file to append a stats record "
+                 "per OD group to, - for stdout)"
+              << std::endl;
+    stats_sink.clear();
+  } else {
+    stats_sink = std::string(stats_env);
+  }
+
+  char* stats_format_env = getenv("SSOTD_STATS_FORMAT");
+  if (stats_format_env == nullptr) {
+    std::cout << "You may specify the env variable SSOTD_STATS_FORMAT (ndjson or csv)" << std::endl;
+    stats_format = default_stats_format;
+  } else {
+    stats_format = std::string(stats_format_env);
+  }
+  if (stats_format != "ndjson" && stats_format != "csv") {
+    std::cerr << "Unknown SSOTD_STATS_FORMAT " << stats_format << ", using "
+              << default_stats_format << std::endl;
+    stats_format = default_stats_format;
+  }
+#ifdef SSOTD_NO_STATS
+  if (!stats_sink.empty())
+    std::cerr << "Built with SSOTD_NO_STATS, ignoring SSOTD_STATS" << std::endl;
+#endif
+
+  if (!front_cache_dir.empty())
+    std::cout << "Caching the Pareto fronts in " << front_cache_dir << " (up to " << front_cache_mb
+              << " MiB)" << std::endl;
+}
@@ -27,6 +27,9 @@
 #include "core/globals.h"
 #include "core/routing.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 using namespace std;
 using ll = long long;
 template <class T>
@@ -50,7 +53,7 @@ pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, i
 
 
 pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> original_route, int k, string optimization) {
-  vector<vector<shared_ptr<ParetoElement>>> paretoFront(adj.size());
+  vector<label_front> paretoFront(adj.size());
   unordered_map<int, bool> is_orig_edge;
   prepare_original_route(original_route, is_orig_edge);
   double qot = k * psychological_model.latency(original_route->a(), original_route->b(), k);
@@ -67,14 +70,22 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   start = chrono::steady_clock::now();
   fill_best_pars_dijkstra(b);
   end = chrono::steady_clock::now();
+  current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
   cout << "Route specific precalculation time: "
         << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
   start = chrono::steady_clock::now();
-  visits = pareto_dijkstra_local_opt_4d(a, a, b, paretoFront, original_route, k, upperBound, is_orig_edge, &lower_bound_score_dijkstra, &astar_prio_dijkstra).second;
+  search_info info;
+  visits = pareto_dijkstra_local_opt_4d(a, a, b, paretoFront, original_route, k, upperBound, is_orig_edge, &lower_bound_score_dijkstra, &astar_prio_dijkstra, &info).second;
     
    end = chrono::steady_clock::now();
    cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
    cout << "Node visits: " << visits << endl;
+   print_pruned(info);
+   current_query.search_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+   current_query.visits += visits;
+   current_query.search.merge(info);
+   current_query.pareto_set += paretoFront[b].size();
+   add_front_sizes(paretoFront);
 
    start = chrono::steady_clock::now();
 
@@ -84,35 +95,42 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 
     if (paretoFront[b].size() > 0) {
 
-      for (shared_ptr<ParetoElement>& par : paretoFront[b]) {
-        auto [ot, usage] =
-          psychological_model.score_route(par->a(), par->b(), original_route->a(),
-                                          original_route->b(), par->shared_a(), par->shared_b(), k);
-        if (ot < best_ot) {
-          best_ot = ot;
-          best_usage = usage;
-          best = par;
-        }
-      }
+      candidate_batch batch;
+      for (shared_ptr<ParetoElement>& par : paretoFront[b])
+        batch.push_back(par->a(), par->b(), par->shared_a(), par->shared_b());
+      batch.score(original_route->a(), original_route->b(), k);
+      size_t i = batch.best();
+      best_ot = batch.ots[i];
+      best_usage = batch.usages[i];
+      best = paretoFront[b][i];
 
         end = chrono::steady_clock::now();
         cout << "Evaluation time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+        current_query.evaluation_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
         cout << "Mean Pareto-set size: " << paretoFront[b].size() << endl;
         cout << "Sum Pareto-set size: " << paretoFront[b].size() << endl;
         cout << "Found " << paretoFront[b].size() << " pareto-optimal routes" << endl; 
-        cout << "\nBEST PARETO OT: " << best_ot << endl;
+        cout << "\nBEST PARETO OT: " << best_ot;
+        if (pareto_epsilon > 0 || info.over_budget)
+          cout << " (epsilon bound: " << approximation_bound(paretoFront[b]) << ")";
+        cout << endl;
         cout << "\nSELECTED ALTERNATIVE: a=" << best->a() << " b=" << best->b() << " sa=" << best->shared_a() << " sb=" << best->shared_b() << endl;
         cout << "b/a=" << best->b() / best->a() << endl;
       } else {
         end = chrono::steady_clock::now();
         cout << "Evaluation time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+        current_query.evaluation_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
         cout << "Mean Pareto-set size: 0" << endl;
         cout << "Sum Pareto-set size: 0" << endl;
         cout << "Found 0 pareto-optimal routes" << endl; 
         cout << "\nBEST PARETO OT: " << qot << endl;
+        if (!info.exhaustive())
+          return best_so_far(info, original_route, k, qot, nullptr, HUGE_VAL, 0.0);
         return {original_route, 0.0};
       }
 
+  if (!info.exhaustive())
+    return best_so_far(info, original_route, k, qot, best->collectRoute(), best_ot, best_usage);
   if (best_ot > qot)
     return {original_route, 0.0};
 
@@ -124,6 +142,9 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 }
 
 void ssotd(int source, int destination, vector<int> pids, string optimization) {
+  start_deadline();
+  begin_query("newnodisjoint", source, destination, pids.size());
+  enter_od_corridor(source, destination);
   shared_ptr<route> original_route = dijkstra(source, destination);
     cout << "Length original: " << original_route->links.size() << endl;
     cout << "K: " << pids.size() << endl;
@@ -132,6 +153,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       ssotd_route(source, destination, original_route, pids.size(), optimization);
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  end_query(ssotd_res.first, original_route, ssotd_res.second);
   double usage = ssotd_res.second / static_cast<double>(pids.size());
   cout << "normalized usage of the pareto route: " << usage << endl;
  
@@ -142,7 +164,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       persons[pid].r = original_route;
   }
   cout << "SSOTD assignment completed." << endl;
-
+  leave_od_corridor(pids);
 }
 
 void do_routing(int argc, char* argv[]) {
@@ -154,20 +176,13 @@ void do_routing(int argc, char* argv[]) {
     optimization = optimization.substr(pos1, pos2 - pos1 + 1);
   } else
     optimization = "none";
+  parse_ssotd_env();
 
 
-  map<pair<pair<int, int>, string>, vector<int>> c;
-  for (unsigned int pid = 0; pid < persons.size(); pid++) {
-    auto& p = persons[pid];
-    string s = p.timestr;  // maybe
-    c[{{p.origin, p.destination}, s}].push_back(pid);
-  }
-  
-
   // do ssotd for all
-  for (auto& [sdts, pv] : c) {
-    number_agents = pv.size();
-    ssotd(sdts.first.first, sdts.first.second, pv, optimization);
+  for (auto& group : od_groups()) {
+    number_agents = group.pids.size();
+    ssotd(group.origin, group.destination, group.pids, optimization);
   }
   cout << "entire SSOTD routing complete" << endl;
 }
@@ -1,3 +1,5 @@
+#include <omp.h>
+
 #include <algorithm>
 #include <bitset>
 #include <chrono>
@@ -14,7 +16,6 @@
 #include <queue>
 #include <random>
 #include <set>
-#include <sstream>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -24,7 +25,11 @@
 #include "core/data.h"
 #include "core/globals.h"
 #include "core/routing.h"
+#include "ssotd/ssotd_cache.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 using namespace std;
 using ll = long long;
 template <class T>
@@ -36,6 +41,7 @@ using minq = priority_queue<T, vector<T>, greater<>>;
 
 class RouteFragment {
  public:
+  double cover = 1.0;  // approximation factor of the fragments this one replaced (SSOTD_EPSILON)
   virtual void add_to(vector<link*>&) const = 0;
   virtual double a() = 0;
   virtual double b() = 0;
@@ -49,9 +55,11 @@ class RouteFragment {
   shared_ptr<ParetoElement> to_par_elem() {
   return make_shared<ParetoElement>(a(), b(), taud(), shared_a(), shared_b(), shared_taud());
 }
-  bool strongly_dominating(shared_ptr<RouteFragment>& other) {
-    return psychological_model.strongly_dominating(this->to_par_elem(), other->to_par_elem());
+  bool strongly_dominating(shared_ptr<RouteFragment>& other, double eps = 0.0) {
+    return psychological_model.strongly_dominating(this->to_par_elem(), other->to_par_elem(), eps);
   }
+  // worst approximation factor of the fragment and its components, like ParetoElement::approx
+  virtual double approx() { return cover; }
 };
 
 class EmptyRouteFragment : public RouteFragment {
@@ -130,6 +138,12 @@ class CompositeRouteFragment : public RouteFragment {
                       [](double su, const shared_ptr<RouteFragment> rf) { return su + rf->shared_taud(); });
     return _staud;
   }
+  virtual double approx() override {
+    double factor = cover;
+    for (auto& rf : components)
+      factor = max(factor, rf->approx());
+    return factor;
+  }
 };
 
 class LinkFragment : public RouteFragment {
@@ -165,6 +179,7 @@ class ParetoElementFragment : public RouteFragment {
   virtual double shared_a() override { return 0.0; }
   virtual double shared_b() override { return 0.0; }
   virtual double shared_taud() override { return 0.0; }
+  virtual double approx() override { return max(cover, p->approx()); }
 };
 
 pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, int from, int to,
@@ -180,7 +195,16 @@ pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, i
   return make_pair(HUGE_VAL, -1);
 }
 
-bool insert_and_dominate(list<shared_ptr<RouteFragment>>& A, shared_ptr<RouteFragment> frag) {
+// Inserts frag into A unless a fragment of A (1 + eps)-dominates it, and removes the fragments
+// frag dominates. A fragment that stands in for one it only epsilon-dominates takes over its
+// approximation factor times 1 + eps, as insert_label does for the labels.
+bool insert_and_dominate(list<shared_ptr<RouteFragment>>& A, shared_ptr<RouteFragment> frag,
+                         double eps) {
+  auto cover = [eps](shared_ptr<RouteFragment>& kept, shared_ptr<RouteFragment>& replaced) {
+    if (eps > 0)
+      kept->cover = max(kept->cover, (kept->strongly_dominating(replaced) ? 1.0 : 1.0 + eps) *
+                                         replaced->approx());
+  };
   bool appended = false;
   auto toBeDeleted = A.end();
   for (auto current_elem = A.begin(); current_elem != A.end(); current_elem++) {
@@ -188,11 +212,13 @@ bool insert_and_dominate(list<shared_ptr<RouteFragment>>& A, shared_ptr<RouteFra
       A.erase(toBeDeleted);
       toBeDeleted = A.end();
     }
-    if ((*current_elem)->strongly_dominating(frag)) {
+    if ((*current_elem)->strongly_dominating(frag, eps)) {
+      cover(*current_elem, frag);
       A.push_front(*current_elem);
       A.erase(current_elem);
       return false;
-    } else if (frag->strongly_dominating(*current_elem)) {
+    } else if (frag->strongly_dominating(*current_elem, eps)) {
+      cover(frag, *current_elem);
       if (appended) {
         toBeDeleted = current_elem;
       } else {
@@ -206,6 +232,51 @@ bool insert_and_dominate(list<shared_ptr<RouteFragment>>& A, shared_ptr<RouteFra
   return true;
 }
 
+// Collects all fragments ending at original route vertex i: the fragments of A[i-1] extended by
+// the original route link and the fragments of every A[j] extended by a bridge of the Pareto front
+// from j to i. The candidates are split among the threads, every thread keeps its own
+// non-dominated set and these sets are merged into Ai afterwards. Fragments are compared with
+// (1 + eps)-dominance.
+long long dp_stage(size_t i, list<shared_ptr<RouteFragment>>& Ai,
+                   vector<vector<shared_ptr<RouteFragment>>>& finalA,
+                   vector<vector<shared_ptr<ParetoElement>>*>& bridges,
+                   shared_ptr<route> original_route, double eps) {
+  // a unit is a fragment of A[j] which gets extended by every bridge from j to i (or the link i-1)
+  vector<pair<size_t, shared_ptr<RouteFragment>>> units;
+  for (size_t j = 0; j < i; j++) {
+    if (j + 1 < i && bridges[j]->empty())
+      continue;
+    for (auto& frag : finalA[j])
+      units.emplace_back(j, frag);
+  }
+
+  long long evaluated = 0;
+  auto appendix = make_shared<LinkFragment>(original_route->links[i - 1], i - 1);
+  int threads = units.size() > 64 ? omp_get_max_threads() : 1;
+  vector<list<shared_ptr<RouteFragment>>> local(threads - 1);  // the first thread works on Ai
+#pragma omp parallel for default(none) shared(units, local, bridges, appendix, i, Ai, eps) \
+    reduction(+ : evaluated) schedule(static) num_threads(threads)
+  for (size_t u = 0; u < units.size(); u++) {
+    auto& [j, frag] = units[u];
+    int t = omp_get_thread_num();
+    auto& front = t == 0 ? Ai : local[t - 1];
+    if (j + 1 == i) {
+      evaluated++;
+      insert_and_dominate(front, make_shared<CompositeRouteFragment>(frag, appendix), eps);
+    }
+    for (auto& bridge : *bridges[j]) {
+      evaluated++;
+      auto bridgeFragment = make_shared<ParetoElementFragment>(bridge);
+      insert_and_dominate(front, make_shared<CompositeRouteFragment>(frag, bridgeFragment), eps);
+    }
+  }
+
+  for (auto& front : local)
+    for (auto& frag : front)
+      insert_and_dominate(Ai, frag, eps);
+  return evaluated;
+}
+
 pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> original_route, int k,
                                             string optimization) {
   map<pair<int, int>, vector<shared_ptr<ParetoElement>>> paretoFronts;
@@ -215,95 +286,121 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 
   cout << "DIJKSTRA OT: " << qot << endl;
   cout << "Calculating pareto fronts." << endl;
-  function<pair<double,int>(int, vector<vector<shared_ptr<ParetoElement>>>*)> pareto_dijk;
-  double upperBound = qot;
-
-  cout << "Doing dijkstra astar optimization" << endl;
+  search_info info;
+  front_cache_slot cache("nodisjoint", a, b, k, *original_route);
   auto start = chrono::steady_clock::now();
-  fill_best_pars_dijkstra(b);
-  fill_best_pars_dijkstra_forward(a);
-  auto end = chrono::steady_clock::now();
-  cout << "Route specific precalculation time: "
-        << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
-  pareto_dijk = [a, b, &original_route, k, &upperBound, &inactive](
-                    int c, vector<vector<shared_ptr<ParetoElement>>>* pareto) {
-    return pareto_dijkstra_local_opt(c, a, b, *pareto, original_route, k, upperBound, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra);
-  };
+  auto end = start;
+  bool cached = cache.load(paretoFronts);
+  if (!cached) {
+    function<pair<double, int>(int, vector<label_front>*, search_info*)>
+        pareto_dijk;
+    double upperBound = qot;
+
+    cout << "Doing dijkstra astar optimization" << endl;
+    start = chrono::steady_clock::now();
+    fill_best_pars_dijkstra(b);
+    fill_best_pars_dijkstra_forward(a);
+    end = chrono::steady_clock::now();
+    current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    cout << "Route specific precalculation time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    pareto_dijk = [a, b, &original_route, k, &upperBound, &inactive](
+                      int c, vector<label_front>* pareto, search_info* info) {
+      return pareto_dijkstra_local_opt(c, a, b, *pareto, original_route, k, upperBound, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, info);
+    };
  
-  long long visits = 0;
-  start = chrono::steady_clock::now();
+    long long visits = 0;
+    start = chrono::steady_clock::now();
 #pragma omp parallel for default(none) shared(paretoFronts, original_route, adj, inactive, upperBound, k, \
-                                              b, pareto_dijk, visits) schedule(dynamic, 2) num_threads(8)
-  for (unsigned int lid = 0; lid < original_route->links.size(); lid++) {
-    // iterate over all vertices of the original route except the last
-    int v = original_route->links[lid]->from;
-    vector<vector<shared_ptr<ParetoElement>>> pareto(adj.size() + 1);
-    auto [newUpperbound, new_visits] = pareto_dijk(v, &pareto);
-    visits += new_visits;
-    if (newUpperbound < upperBound)
-      upperBound = newUpperbound;
+                                                b, pareto_dijk, visits, info) schedule(dynamic, 2) num_threads(8)
+    for (unsigned int lid = 0; lid < original_route->links.size(); lid++) {
+      // iterate over all vertices of the original route except the last
+      int v = original_route->links[lid]->from;
+      vector<label_front> pareto(adj.size() + 1);
+      search_info search;
+      auto [newUpperbound, new_visits] = pareto_dijk(v, &pareto, &search);
+      visits += new_visits;
+      if (newUpperbound < upperBound)
+        upperBound = newUpperbound;
 
 
 #pragma omp critical
-    for (unsigned int _lid = lid + 1; _lid < original_route->links.size(); _lid++) {
-      paretoFronts[{lid, _lid}] = pareto[original_route->links[_lid]->from];
+      {
+        info.merge(search);
+        for (unsigned int _lid = lid + 1; _lid < original_route->links.size(); _lid++) {
+          paretoFronts[{lid, _lid}] = pareto[original_route->links[_lid]->from];
+        }
+        paretoFronts[{lid, original_route->links.size()}] = pareto[original_route->links.back()->to];
+      }
     }
-    paretoFronts[{lid, original_route->links.size()}] = pareto[original_route->links.back()->to];
+    end = chrono::steady_clock::now();
+    cout << "Node visits: " << visits << endl;
+    print_pruned(info);
+    cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    current_query.search_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    current_query.visits += visits;
+    current_query.search.merge(info);
+    if (info.exhaustive())
+      cache.store(paretoFronts);
   }
-  end = chrono::steady_clock::now();
-  cout << "Node visits: " << visits << endl;
-  cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  add_front_sizes(paretoFronts);
 
   // DP
   cout << "starting arbitrary disjoint dp" << endl;
 
 
-  stringstream statsCsv;
-
   start = chrono::steady_clock::now();
 
-  int counter = 0;
+  long long counter = 0;
   int n = original_route->links.size() + 1;
   auto pareto_sizes = vector<int>(n*n/2-n);  //n^2/2 - n Pareto-Fronts
   vector<list<shared_ptr<RouteFragment>>> A(original_route->links.size() + 1);
+  vector<vector<shared_ptr<RouteFragment>>> finalA(original_route->links.size() + 1);
   A[0].push_back(make_shared<EmptyRouteFragment>());
+  finalA[0].assign(A[0].begin(), A[0].end());
+  // the stages share the factor 1 + SSOTD_EPSILON, a route replaced once per stage stays within it
+  double stage_eps = pareto_epsilon > 0
+                         ? pow(1 + pareto_epsilon, 1.0 / original_route->links.size()) - 1
+                         : 0.0;
   for (size_t i = 1; i <= original_route->links.size(); i++) {
-    auto appendix = make_shared<LinkFragment>(original_route->links[i - 1], i - 1);
-    for (auto& frag : A[i - 1]) {
-      counter++;
-      auto newFrag = make_shared<CompositeRouteFragment>(frag, appendix);
-      insert_and_dominate(A[i], newFrag);
+    if (deadline_passed()) {
+      // nothing is known about the combinations the DP did not get to, only the A* bound holds
+      info.timed_out = true;
+      if (cached) {  // the bounds were not needed for the search
+        fill_best_pars_dijkstra(b);
+        fill_best_pars_dijkstra_forward(a);
+      }
+      info.lower_bound = min(info.lower_bound, lower_bound_score_dijkstra(make_shared<ParetoElement>(),
+                                                                          a, b, a, a, original_route, k).first);
+      break;
     }
+    vector<vector<shared_ptr<ParetoElement>>*> bridges(i);
     for (size_t j = 0; j < i; j++) {
-      pareto_sizes.push_back(paretoFronts[{j, i}].size());
-      for (auto& frag : A[j]) {
-        for (auto& bridge : paretoFronts[{j, i}]) {
-          counter++;
-          auto bridgeFragment = make_shared<ParetoElementFragment>(bridge);
-          auto newFrag = make_shared<CompositeRouteFragment>(frag, bridgeFragment);  // create copy
-          insert_and_dominate(A[i], newFrag);
-        }
-      }
+      bridges[j] = &paretoFronts[{j, i}];
+      pareto_sizes.push_back(bridges[j]->size());
     }
-
+    counter += dp_stage(i, A[i], finalA, bridges, original_route, stage_eps);
+    finalA[i].assign(A[i].begin(), A[i].end());
   }
   double best_ot = numeric_limits<double>::max();
   double best_usage = 0.0;
   shared_ptr<RouteFragment> best;
 
-  for (shared_ptr<RouteFragment>& frag : A[original_route->links.size()]) {
-    auto [ot, usage] =
-      psychological_model.score_route(frag->a(), frag->b(), original_route->a(),
-                                      original_route->b(), frag->shared_a(), frag->shared_b(), k);
-    if (ot < best_ot) {
-      best_ot = ot;
-      best_usage = usage;
-      best = frag;
-    }
-  } 
+  auto& complete = A[original_route->links.size()];
+  candidate_batch batch;
+  for (shared_ptr<RouteFragment>& frag : complete)
+    batch.push_back(frag->a(), frag->b(), frag->shared_a(), frag->shared_b());
+  batch.score(original_route->a(), original_route->b(), k);
+  if (size_t i = batch.best(); i < batch.size()) {
+    best_ot = batch.ots[i];
+    best_usage = batch.usages[i];
+    best = *next(complete.begin(), i);
+  }
   end = chrono::steady_clock::now();
   cout << "Evaluation time: "
         << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.evaluation_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  current_query.pareto_set += complete.size();
     
     auto total_paretosizes = accumulate(pareto_sizes.begin(), pareto_sizes.end(), 0);
     nth_element(pareto_sizes.begin(), pareto_sizes.begin() + pareto_sizes.size() / 2, pareto_sizes.end());
@@ -322,7 +419,24 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
     cout << "Found " << A[original_route->links.size()].size() << " pareto-optimal routes" << endl;
     cout << "evaluated " << counter << " pareto parts" << endl;
 
-  cout << "\nBEST PARETO OT: " << best_ot << endl;
+  cout << "\nBEST PARETO OT: " << best_ot;
+  if (pareto_epsilon > 0 || info.over_budget) {
+    // the complete fragments stand in for every route, with the bridges and DP stages they replaced
+    double epsilon_bound = 1.0;
+    for (auto& frag : complete)
+      epsilon_bound = max(epsilon_bound, frag->approx());
+    cout << " (epsilon bound: " << epsilon_bound << ")";
+  }
+  cout << endl;
+  if (!info.exhaustive()) {
+    shared_ptr<route> selected;
+    if (best) {
+      vector<link*> altLinks;
+      best->add_to(altLinks);
+      selected = make_shared<route>(altLinks);
+    }
+    return best_so_far(info, original_route, k, qot, selected, best_ot, best_usage);
+  }
   cout << "\nSELECTED ALTERNATIVE: a=" << best->a() << " b=" << best->b()
        << " sa=" << best->shared_a() << " sb=" << best->shared_b() << endl;
   cout << "b/a=" << best->b() / best->a() << endl;
@@ -338,6 +452,9 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
 }
 
 void ssotd(int source, int destination, vector<int> pids, string optimization) {
+  start_deadline();
+  begin_query("nodisjoint", source, destination, pids.size());
+  enter_od_corridor(source, destination);
   shared_ptr<route> original_route = dijkstra(source, destination);
     cout << "Length original: " << original_route->links.size() << endl;
     cout << "K: " << pids.size() << endl;
@@ -350,6 +467,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       ssotd_route(source, destination, original_route, pids.size(), optimization);
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  end_query(ssotd_res.first, original_route, ssotd_res.second);
   double usage = ssotd_res.second / static_cast<double>(pids.size());
   cout << "normalized usage of the pareto route: " << usage << endl;
   for (int pid : pids) {
@@ -359,7 +477,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       persons[pid].r = original_route;
   }
   cout << "SSOTD assignment completed." << endl;
-
+  leave_od_corridor(pids);
 }
 
 void do_routing(int argc, char* argv[]) {
@@ -372,17 +490,13 @@ void do_routing(int argc, char* argv[]) {
     optimization = optimization.substr(pos1, pos2 - pos1 + 1);
   } else
     optimization = "none";
+  parse_ssotd_env();
 
-  map<pair<pair<int, int>, string>, vector<int>> c;
-  for (unsigned int pid = 0; pid < persons.size(); pid++) {
-    auto& p = persons[pid];
-    string s = p.timestr;  // maybe
-    c[{{p.origin, p.destination}, s}].push_back(pid);
-  }
   // do ssotd for all
-  for (auto& [sdts, pv] : c) {
-    number_agents = pv.size();
-    ssotd(sdts.first.first, sdts.first.second, pv, optimization);
+  for (auto& group : od_groups()) {
+    number_agents = group.pids.size();
+    ssotd(group.origin, group.destination, group.pids, optimization);
   }
+  print_front_cache_stats();
   cout << "entire SSOTD routing complete" << endl;
 }
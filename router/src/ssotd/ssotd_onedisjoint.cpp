@@ -21,7 +21,11 @@
 
 #include "core/data.h"
 #include "core/globals.h"
+#include "ssotd/ssotd_cache.h"
 #include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
 using namespace std;
 using ll = long long;
 
@@ -34,15 +38,40 @@ pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, i
                                                 int k) {
   (void) from; (void) to;
   int idc = index_in_original(c);
-  double newA = par->a() + origPartA.at(idc) + bestAs[v];
-  double newB = par->b() + origPartB.at(idc) + bestBs[v];
-  auto score = psychological_model.score_route(newA, newB, original_route->a(),
-                                               original_route->b(), origPartA.at(idc), origPartB.at(idc), k);
-  if (score.second > 0)
-    return make_pair(score.first, score_for_relax(idc, index_in_original(v), par, k));
+  auto bound = [&](double restA, double restB) {
+    auto score = psychological_model.score_route(par->a() + origPartA.at(idc) + restA,
+                                                 par->b() + origPartB.at(idc) + restB, original_route->a(),
+                                                 original_route->b(), origPartA.at(idc), origPartB.at(idc), k);
+    return score.second > 0 ? score.first : HUGE_VAL;
+  };
+  // the detour has to get back onto the original route without using its links
+  last_bound.target_bound = bound(bestAs[v], bestBs[v]);
+  last_bound.rule = bound_rule::target;
+  double ot = last_bound.target_bound;
+  if (rejoinAs[v] == HUGE_VAL) {
+    ot = HUGE_VAL;
+  } else if (rejoinAs[v] > bestAs[v] || rejoinBs[v] > bestBs[v]) {
+    ot = max(ot, bound(max(bestAs[v], rejoinAs[v]), max(bestBs[v], rejoinBs[v])));
+  }
+  if (ot > last_bound.target_bound)
+    last_bound.rule = bound_rule::rejoin;
+  if (ot < HUGE_VAL)
+    return make_pair(ot, score_for_relax(idc, index_in_original(v), par, k));
   return make_pair(HUGE_VAL, -1);
 }
 
+struct candidate_score {
+  double ot;
+  size_t idx;
+};
+
+#pragma omp declare reduction(argmin : candidate_score                                            \
+                              : omp_out = (omp_in.ot < omp_out.ot ||                              \
+                                           (omp_in.ot == omp_out.ot && omp_in.idx < omp_out.idx)) \
+                                              ? omp_in                                            \
+                                              : omp_out)                                          \
+    initializer(omp_priv = omp_orig)
+
 void sanity_check_1D(unordered_map<int, bool> original_edges, shared_ptr<route> alternative, shared_ptr<route> original, double score, int usage, int k) {
 
   int crosses = 0;
@@ -92,47 +121,67 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   double qot = k * psychological_model.latency(original_route->a(), original_route->b(), k);
   cout << "DIJKSTRA OT: " << qot << std::endl;
   cout << "Calculating pareto fronts." << endl;
-  function<pair<double, int>(int, vector<vector<shared_ptr<ParetoElement>>>*)> pareto_dijk;
+  search_info info;
+  front_cache_slot cache("onedisjoint", a, b, k, *original_route);
+  auto start = chrono::steady_clock::now();
+  auto end = start;
+  if (!cache.load(paretoFronts)) {
+    function<pair<double, int>(int, vector<label_front>*, search_info*)>
+        pareto_dijk;
 
   
-  cout << "Doing dijkstra astar optimization" << endl;
-  bestAs = vector<double>(nodes.size(),0);
-  bestBs = vector<double>(nodes.size(),0);
-  auto start = chrono::steady_clock::now();
-  fill_best_pars_dijkstra(b);
-  auto end = chrono::steady_clock::now();
-  cout << "Route specific precalculation time: "
-        << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
-  pareto_dijk = [a, b, &original_route, k, &qot, &inactive](
-                    int c, vector<vector<shared_ptr<ParetoElement>>>* pareto) {
-    return pareto_dijkstra_local_opt(c, a, b, *pareto, original_route, k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra);
-  };
+    cout << "Doing dijkstra astar optimization" << endl;
+    bestAs = vector<double>(nodes.size(),0);
+    bestBs = vector<double>(nodes.size(),0);
+    start = chrono::steady_clock::now();
+    fill_best_pars_dijkstra(b);
+    fill_rejoin_bounds(original_route, inactive);
+    end = chrono::steady_clock::now();
+    current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    cout << "Route specific precalculation time: "
+          << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    pareto_dijk = [a, b, &original_route, k, &qot, &inactive](
+                      int c, vector<label_front>* pareto, search_info* info) {
+      return pareto_dijkstra_local_opt(c, a, b, *pareto, original_route, k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, info);
+    };
  
 
-  start = chrono::steady_clock::now();
-  double upperBound = qot;
-  ll visits = 0;
+    start = chrono::steady_clock::now();
+    double upperBound = qot;
+    ll visits = 0;
 #pragma omp parallel for default(none) shared(paretoFronts, original_route, adj, inactive, upperBound, k, \
-                                              b, pareto_dijk, visits) schedule(dynamic, 2) num_threads(8)
+                                                b, pareto_dijk, visits, info) schedule(dynamic, 2) num_threads(8)
 
-  for (unsigned int lid = 0; lid < original_route->links.size(); lid++) {
-    // iterate over all vertices of the original route except the last
-    int v = original_route->links[lid]->from;
-    vector<vector<shared_ptr<ParetoElement>>> pareto(adj.size() + 1);
-    auto [newUpperBound, new_visits] = pareto_dijk(v, &pareto);
-    visits += new_visits;
-    if (newUpperBound < upperBound)
-      upperBound = newUpperBound;
+    for (unsigned int lid = 0; lid < original_route->links.size(); lid++) {
+      // iterate over all vertices of the original route except the last
+      int v = original_route->links[lid]->from;
+      vector<label_front> pareto(adj.size() + 1);
+      search_info search;
+      auto [newUpperBound, new_visits] = pareto_dijk(v, &pareto, &search);
+      visits += new_visits;
+      if (newUpperBound < upperBound)
+        upperBound = newUpperBound;
 
 #pragma omp critical
-    for (unsigned int _lid = lid + 1; _lid < original_route->links.size(); _lid++) {
-      paretoFronts[{lid, _lid}] = pareto[original_route->links[_lid]->from];
+      {
+        info.merge(search);
+        for (unsigned int _lid = lid + 1; _lid < original_route->links.size(); _lid++) {
+          paretoFronts[{lid, _lid}] = pareto[original_route->links[_lid]->from];
+        }
+        paretoFronts[{lid, original_route->links.size()}] = pareto[original_route->links.back()->to];
+      }
     }
-    paretoFronts[{lid, original_route->links.size()}] = pareto[original_route->links.back()->to];
+    end = chrono::steady_clock::now();
+    cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+    cout << "Node visits: " << visits << endl;
+    print_pruned(info);
+    current_query.search_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    current_query.visits += visits;
+    current_query.search.merge(info);
+    if (info.exhaustive())
+      cache.store(paretoFronts);
   }
-  end = chrono::steady_clock::now();
-  cout << "Pareto-dijkstra time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
-  cout << "Node visits: " << visits << endl;
+  add_front_sizes(paretoFronts);
   cout << "start evaluation" << endl;
  
 
@@ -146,27 +195,47 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   int n = (original_route->links.size()+1);
   auto pareto_sizes = vector<int>(n*n/2-n);  //n^2/2 - n Pareto-Fronts
 
+  // flatten all bridges into arrays, so the candidates can be scored in one batch
+  vector<shared_ptr<ParetoElement>> candidates;
+  vector<pair<int, int>> candidateIJ;
+  candidate_batch batch;
   for (unsigned int i = 0; i < original_route->links.size(); i++) {
     for (unsigned int j = i+1; j < original_route->links.size() + 1; j++) {
-      pareto_sizes.push_back(paretoFronts[{i,j}].size());
-      for (auto par : paretoFronts[{i,j}]) {
-        shared_a = origPartA[i] + origPartA.back() - origPartA[j];
-        shared_b = origPartB[i] + origPartB.back() - origPartB[j];
-        auto [ot, usage] = psychological_model.score_route(par->a() + shared_a, par->b() + shared_b, origPartA.back(),
-                                      origPartB.back(), shared_a, shared_b, k);
-         if (ot < best_ot) {
-          best_ot = ot;
-          best_usage = usage;
-          best = par;
-          bestI = i;
-          bestJ = j;
-        }
+      auto& front = paretoFronts[{i, j}];
+      pareto_sizes.push_back(front.size());
+      shared_a = origPartA[i] + origPartA.back() - origPartA[j];
+      shared_b = origPartB[i] + origPartB.back() - origPartB[j];
+      for (auto& par : front) {
+        candidates.push_back(par);
+        candidateIJ.emplace_back(i, j);
+        batch.push_back(par->a() + shared_a, par->b() + shared_b, shared_a, shared_b);
       }
     }
   }
+
+  batch.score(origPartA.back(), origPartB.back(), k);
+  auto& ots = batch.ots;
+
+  // argmin, ties go to the lower index just like in a sequential scan
+  candidate_score best_candidate = {best_ot, candidates.size()};
+#pragma omp parallel for default(none) shared(ots) reduction(argmin : best_candidate) \
+    schedule(static)
+  for (size_t c = 0; c < ots.size(); c++) {
+    if (ots[c] < best_candidate.ot || (ots[c] == best_candidate.ot && c < best_candidate.idx))
+      best_candidate = {ots[c], c};
+  }
+  if (best_candidate.idx < candidates.size() && best_candidate.ot < best_ot) {
+    best_ot = best_candidate.ot;
+    best_usage = batch.usages[best_candidate.idx];
+    best = candidates[best_candidate.idx];
+    bestI = candidateIJ[best_candidate.idx].first;
+    bestJ = candidateIJ[best_candidate.idx].second;
+  }
   end = chrono::steady_clock::now();
   cout << "Evaluation time: "
         << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  current_query.evaluation_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  current_query.pareto_set += candidates.size();
 
   shared_a = origPartA[bestI] + origPartA.back() - origPartA[bestJ];
   shared_b = origPartB[bestI] + origPartB.back() - origPartB[bestJ];
@@ -178,11 +247,20 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   cout << "Mean Pareto-set size: " << mean_pareto_set_size << endl;
   cout << "Sum Pareto-set size: " << total_candidates << endl;
   if (total_candidates > 0) {
-  cout << "\nBEST PARETO OT: " << best_ot << endl;
+  cout << "\nBEST PARETO OT: " << best_ot;
+  if (pareto_epsilon > 0 || info.over_budget) {
+    double epsilon_bound = 1.0;
+    for (auto& [ij, front] : paretoFronts)
+      epsilon_bound = max(epsilon_bound, approximation_bound(front));
+    cout << " (epsilon bound: " << epsilon_bound << ")";
+  }
+  cout << endl;
   cout << "BEST PARETO SHARES " << bestI + original_route->links.size() - bestJ << " of " << original_route->links.size() << " edges of the original route (leaving at " << bestI 
        << " and reuniting at " << bestJ << ")" <<endl;
   }
-  if (best_ot > qot)
+  if (!info.exhaustive() && !best)
+    return best_so_far(info, original_route, k, qot, nullptr, HUGE_VAL, 0.0);
+  if (best_ot > qot && info.exhaustive())
     return {original_route, 0.0};
 
   vector<link*> parLinks = *(best->collectLinks());
@@ -192,12 +270,17 @@ pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> orig
   copy(parLinks.begin(), parLinks.end(), back_inserter(routeLinks));
   copy(original_route->links.begin() + bestJ, original_route->links.end(), back_inserter(routeLinks));
   auto res = make_shared<route>(routeLinks);
+  if (!info.exhaustive())
+    return best_so_far(info, original_route, k, qot, res, best_ot, best_usage);
   cout << "Collected SSOTD route" << endl;
 
   return {res, best_usage};
 }
 
 void ssotd(int source, int destination, vector<int> pids, string optimization) {
+  start_deadline();
+  begin_query("onedisjoint", source, destination, pids.size());
+  enter_od_corridor(source, destination);
   shared_ptr<route> original_route = dijkstra(source, destination);
     cout << "Length original: " << original_route->links.size() << endl;
     cout << "K: " << pids.size() << endl;
@@ -210,6 +293,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       ssotd_route(source, destination, original_route, pids.size(), optimization);
   auto end = chrono::steady_clock::now();
   cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  end_query(ssotd_res.first, original_route, ssotd_res.second);
   double usage = ssotd_res.second / static_cast<double>(pids.size());
   cout << "normalized usage of the pareto route: " << usage << endl;
   for (int pid : pids) {
@@ -219,6 +303,7 @@ void ssotd(int source, int destination, vector<int> pids, string optimization) {
       persons[pid].r = original_route;
   }
   cout << "SSOTD assignment completed." << endl;
+  leave_od_corridor(pids);
 }
 
 void do_routing(int argc, char* argv[]) {
@@ -230,17 +315,13 @@ void do_routing(int argc, char* argv[]) {
     optimization = optimization.substr(pos1, pos2 - pos1 + 1);
   } else
     optimization = "none";
+  parse_ssotd_env();
 
-  map<pair<pair<int, int>, string>, vector<int>> c;
-  for (unsigned int pid = 0; pid < persons.size(); pid++) {
-    auto& p = persons[pid];
-    string s = p.timestr;  // maybe
-    c[{{p.origin, p.destination}, s}].push_back(pid);
-  }
   // do ssotd for all
-  for (auto& [sdts, pv] : c) {
-    number_agents = pv.size();
-    ssotd(sdts.first.first, sdts.first.second, pv, optimization);
+  for (auto& group : od_groups()) {
+    number_agents = group.pids.size();
+    ssotd(group.origin, group.destination, group.pids, optimization);
   }
+  print_front_cache_stats();
   cout << "entire SSOTD routing complete" << endl;
 }
@@ -0,0 +1,126 @@
+#include "ssotd/ssotd_stats.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#include "core/globals.h"
+#include "ssotd/ssotd_globals.h"
+
+using namespace std;
+
+query_stats current_query;
+
+#ifndef SSOTD_NO_STATS
+namespace {
+
+auto query_start = chrono::steady_clock::now();
+
+// the stream of SSOTD_STATS, opened (for appending) on the first record
+ostream* sink = nullptr;
+ofstream sink_file;
+
+ostream* open_sink() {
+  if (sink || stats_sink.empty())
+    return sink;
+  if (stats_sink == "-") {
+    sink = &cout;
+  } else {
+    sink_file.open(stats_sink, ios::app);
+    if (!sink_file) {
+      cerr << "Could not open the stats file " << stats_sink << ", writing no stats" << endl;
+      stats_sink.clear();
+      return nullptr;
+    }
+    sink = &sink_file;
+  }
+  // a new CSV file starts with its header
+  if (stats_format == "csv" && (sink == &cout || sink_file.tellp() == 0))
+    *sink << "variant,source,destination,k,precalc_us,search_us,evaluation_us,total_us,visits,"
+             "labels_created,labels_dominated,pruned_target,pruned_rejoin,pruned_suffix,revisits,"
+             "pushes,pops,pareto_set,front_sizes,exhaustive,ot,usage,peak_rss_kb\n";
+  return sink;
+}
+
+// the OT of the OD group if usage of its agents take the alternative, which may share links
+// with the original route
+double query_ot(shared_ptr<route> alternative, shared_ptr<route> original_route, double usage) {
+  int k = current_query.k;
+  if (usage <= 0 || alternative == original_route)
+    return k * psychological_model.latency(original_route->a(), original_route->b(), k);
+  unordered_set<int> original_links;
+  for (link* l : original_route->links)
+    original_links.insert(l->id);
+  double sa = 0, sb = 0;
+  for (link* l : alternative->links)
+    if (original_links.count(l->id)) {
+      sa += l->a();
+      sb += l->b();
+    }
+  return psychological_model.score_route(alternative->a(), alternative->b(), original_route->a(),
+                                         original_route->b(), sa, sb, k).first;
+}
+
+}  // namespace
+#endif
+
+void begin_query(const string& variant, int source, int destination, int k) {
+  current_query = query_stats();
+  current_query.variant = variant;
+  current_query.source = source;
+  current_query.destination = destination;
+  current_query.k = k;
+#ifndef SSOTD_NO_STATS
+  query_start = chrono::steady_clock::now();
+#endif
+}
+
+void end_query(shared_ptr<route> alternative, shared_ptr<route> original_route, double usage) {
+#ifndef SSOTD_NO_STATS
+  ostream* out = open_sink();
+  if (!out)
+    return;
+  auto& q = current_query;
+  q.total_us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() -
+                                                          query_start).count();
+  rusage usage_self;
+  if (getrusage(RUSAGE_SELF, &usage_self) == 0)
+    q.peak_rss_kb = usage_self.ru_maxrss;
+  double ot = query_ot(alternative, original_route, usage);
+  auto& s = q.search;
+  bool csv = stats_format == "csv";
+  ostringstream sizes;
+  for (size_t i = 0; i < q.front_sizes.size(); i++)
+    sizes << (i ? (csv ? " " : ",") : "") << q.front_sizes[i];
+  ostringstream record;
+  record.precision(17);
+  if (csv) {
+    record << q.variant << ',' << q.source << ',' << q.destination << ',' << q.k << ','
+           << q.precalc_us << ',' << q.search_us << ',' << q.evaluation_us << ',' << q.total_us
+           << ',' << q.visits << ',' << s.created << ',' << s.dominated << ',' << s.pruned[0]
+           << ',' << s.pruned[1] << ',' << s.pruned[2] << ',' << s.revisits << ',' << s.pushes
+           << ',' << s.pops << ',' << q.pareto_set << ',' << sizes.str() << ','
+           << s.exhaustive() << ',' << ot << ',' << usage << ',' << q.peak_rss_kb << '\n';
+  } else {
+    record << "{\"variant\":\"" << q.variant << "\",\"source\":" << q.source
+           << ",\"destination\":" << q.destination << ",\"k\":" << q.k
+           << ",\"precalc_us\":" << q.precalc_us << ",\"search_us\":" << q.search_us
+           << ",\"evaluation_us\":" << q.evaluation_us << ",\"total_us\":" << q.total_us
+           << ",\"visits\":" << q.visits << ",\"labels_created\":" << s.created
+           << ",\"labels_dominated\":" << s.dominated << ",\"pruned_target\":" << s.pruned[0]
+           << ",\"pruned_rejoin\":" << s.pruned[1] << ",\"pruned_suffix\":" << s.pruned[2]
+           << ",\"revisits\":" << s.revisits << ",\"pushes\":" << s.pushes
+           << ",\"pops\":" << s.pops << ",\"pareto_set\":" << q.pareto_set
+           << ",\"front_sizes\":[" << sizes.str() << "],\"exhaustive\":"
+           << (s.exhaustive() ? "true" : "false") << ",\"ot\":" << ot << ",\"usage\":" << usage
+           << ",\"peak_rss_kb\":" << q.peak_rss_kb << "}\n";
+  }
+  *out << record.str() << flush;
+#else
+  (void) alternative; (void) original_route; (void) usage;
+#endif
+}
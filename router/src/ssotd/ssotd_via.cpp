@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "core/data.h"
+#include "core/globals.h"
+#include "core/routing.h"
+#include "ssotd/ssotd_core.h"
+#include "ssotd/ssotd_globals.h"
+#include "ssotd/ssotd_io.h"
+#include "ssotd/ssotd_stats.h"
+
+using namespace std;
+using ll = long long;
+
+// This file is a heuristic for D-SAP: instead of a Pareto search, it only considers the
+// alternatives that follow a shortest path tree from the origin to some via node and another one
+// from there to the destination (via-node and plateau alternatives). All trees avoid the links of
+// the original route, like the fulldisjoint search. It needs one one-to-all search per direction,
+// which computes the distances in a and b at once, and returns in milliseconds. The result is not
+// optimal; SSOTD_VIA_EXACT=1 runs the fulldisjoint search as well and reports the gap.
+
+// A shortest path tree in the a or the b metric, rooted at the origin (forward, next is the link
+// into a node) or the destination (backward, next is the link out of a node), with the a and b of
+// the tree path of each node.
+struct shortest_tree {
+  vector<link*> next;
+  vector<double> a, b;
+};
+
+// The tree of the distances dist (bestAs, bestBs and their forward counterparts): every node
+// takes the first active link that is tight, i.e. on which dist grows by the length of the link.
+shortest_tree build_tree(int anchor, bool forward, const vector<double>& dist, metric m,
+                         const unordered_map<int, bool>& inactive) {
+  size_t n = adj.size();
+  shortest_tree tree{vector<link*>(n, nullptr), vector<double>(n, HUGE_VAL),
+                     vector<double>(n, HUGE_VAL)};
+  for (auto& out : adj)
+    for (link* l : out) {
+      int tail = forward ? l->from : l->to, head = forward ? l->to : l->from;
+      double length = m == metric::a ? l->a() : l->b();
+      if (tree.next[head] || length <= 0 || dist[tail] == HUGE_VAL)
+        continue;
+      if (fabs(dist[tail] + length - dist[head]) <= 1e-9 * max(1.0, dist[head]) &&
+          !inactive.count(l->id))
+        tree.next[head] = l;
+    }
+  // the lengths are positive, so the tail of a tree link comes before its head
+  vector<int> order(n);
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(), [&dist](int v, int w) { return dist[v] < dist[w]; });
+  tree.a[anchor] = tree.b[anchor] = 0;
+  for (int v : order) {
+    link* l = tree.next[v];
+    if (v == anchor || !l)
+      continue;
+    int tail = forward ? l->from : l->to;
+    tree.a[v] = tree.a[tail] + l->a();
+    tree.b[v] = tree.b[tail] + l->b();
+  }
+  return tree;
+}
+
+// the links from the origin to v along fwd and from v to the destination along bwd, empty if the
+// two parts share a node
+vector<link*> via_path(int v, const shortest_tree& fwd, const shortest_tree& bwd) {
+  vector<link*> links;
+  unordered_set<int> seen = {v};
+  for (int w = v; fwd.next[w]; w = fwd.next[w]->from) {
+    links.push_back(fwd.next[w]);
+    seen.insert(fwd.next[w]->from);
+  }
+  reverse(links.begin(), links.end());
+  for (int w = v; bwd.next[w]; w = bwd.next[w]->to) {
+    links.push_back(bwd.next[w]);
+    if (!seen.insert(bwd.next[w]->to).second)
+      return {};
+  }
+  return links;
+}
+
+int plateau_root(vector<int>& parent, int v) {
+  while (parent[v] != v)
+    v = parent[v] = parent[parent[v]];
+  return v;
+}
+
+// A via-node alternative: the forward tree path to v plus the backward tree path from v, of
+// the trees forward[trees / 2] and backward[trees % 2]
+struct via_candidate {
+  double a, b;
+  int v, trees;
+};
+
+// The via-node alternatives of one pair of trees. A link that is in both trees (a plateau) joins
+// its end nodes, whose alternatives are the same path, so every plateau is one candidate.
+void add_via_candidates(const shortest_tree& fwd, const shortest_tree& bwd, int trees,
+                        vector<via_candidate>& candidates, ll& plateau_nodes) {
+  vector<int> parent(adj.size());
+  iota(parent.begin(), parent.end(), 0);
+  for (auto& out : adj)
+    for (link* l : out)
+      if (fwd.next[l->to] == l && bwd.next[l->from] == l)
+        parent[plateau_root(parent, l->to)] = plateau_root(parent, l->from);
+  for (size_t v = 0; v < adj.size(); v++) {
+    if (fwd.a[v] == HUGE_VAL || bwd.a[v] == HUGE_VAL)
+      continue;
+    if (plateau_root(parent, v) != static_cast<int>(v)) {
+      plateau_nodes++;
+      continue;
+    }
+    candidates.push_back({fwd.a[v] + bwd.a[v], fwd.b[v] + bwd.b[v], static_cast<int>(v), trees});
+  }
+}
+
+// Moves the candidates no other one beats in both a and b to the end of candidates (sorted by a)
+// and returns where they start. The OT of an alternative grows with its a and b, so the best
+// candidate is among them, unless they all loop.
+size_t split_pareto_layer(vector<via_candidate>& candidates) {
+  sort(candidates.begin(), candidates.end(), [](const via_candidate& x, const via_candidate& y) {
+    return x.a != y.a ? x.a > y.a : x.b > y.b;
+  });
+  // from the back, i.e. by increasing a: a candidate is in the layer if its b is the lowest yet
+  vector<via_candidate> rest, layer;
+  double min_b = HUGE_VAL;
+  for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+    if (it->b < min_b) {
+      min_b = it->b;
+      layer.push_back(*it);
+    } else {
+      rest.push_back(*it);
+    }
+  candidates = move(rest);
+  size_t begin = candidates.size();
+  candidates.insert(candidates.end(), layer.begin(), layer.end());
+  return begin;
+}
+
+// the OTs of the heuristic and of the exact search per OD group (SSOTD_VIA_EXACT)
+struct via_gap {
+  ll groups = 0;
+  double sum = 0, max = 0;
+  ll via_us = 0, exact_us = 0;
+};
+via_gap gaps;
+
+pair<double, double> lower_bound_score_dijkstra(shared_ptr<ParetoElement> par, int from, int to, int c, int v,
+                                  shared_ptr<route> original_route, int k) {
+  (void) from; (void) c;
+  auto score = psychological_model.score_route(par->a() + bestAs[v], par->b() + bestBs[v], original_route->a(), original_route->b(), 0 , 0, k);
+  if (score.second > 0)
+    return make_pair(score.first, to == v ? score.first : -1);
+  return make_pair(HUGE_VAL, -1);
+}
+
+// the OT of the fulldisjoint search, for the gap of the heuristic (needs the bounds towards b)
+double exact_ot(int a, int b, shared_ptr<route> original_route, int k, double qot,
+                unordered_map<int, bool>& inactive) {
+  vector<label_front> pareto(adj.size());
+  search_info info;
+  pareto_dijkstra_local_opt(a, a, b, pareto, original_route, k, qot, inactive, &lower_bound_score_dijkstra, &astar_prio_dijkstra, &info);
+  candidate_batch batch;
+  for (auto& par : pareto[b])
+    batch.push_back(par->a(), par->b(), 0, 0);
+  batch.score(original_route->a(), original_route->b(), k);
+  size_t best = batch.best();
+  if (!info.exhaustive())
+    cout << "The exact search was cut short, the gap is not exact" << endl;
+  return best < batch.size() ? min(batch.ots[best], qot) : qot;
+}
+
+pair<shared_ptr<route>, double> ssotd_route(int a, int b, shared_ptr<route> original_route, int k,
+                                            string optimization) {
+  (void)optimization;
+  unordered_map<int, bool> inactive;
+  for (link* l : original_route->links)
+    inactive[l->id] = true;
+  double qot = k * psychological_model.latency(original_route->a(), original_route->b(), k);
+  std::cout << "DIJKSTRA OT: " << qot << std::endl;
+
+  auto start = chrono::steady_clock::now();
+  fill_best_pars_dijkstra(b, inactive);
+  fill_best_pars_dijkstra_forward(a, inactive);
+  auto end = chrono::steady_clock::now();
+  current_query.precalc_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+  cout << "Route specific precalculation time: "
+       << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+
+  start = chrono::steady_clock::now();
+  shortest_tree forward[2] = {build_tree(a, true, bestAsForward, metric::a, inactive),
+                              build_tree(a, true, bestBsForward, metric::b, inactive)};
+  shortest_tree backward[2] = {build_tree(b, false, bestAs, metric::a, inactive),
+                               build_tree(b, false, bestBs, metric::b, inactive)};
+  // every combination of trees, as the best alternative may be short in a on one side of the
+  // via node and short in b on the other
+  vector<via_candidate> candidates;
+  ll plateau_nodes = 0;
+  for (int f = 0; f < 2; f++)
+    for (int r = 0; r < 2; r++)
+      add_via_candidates(forward[f], backward[r], f * 2 + r, candidates, plateau_nodes);
+  size_t count = candidates.size();
+
+  // the candidates layer by layer, only the next layer if every used one of a layer loops
+  shared_ptr<route> best;
+  double best_ot = HUGE_VAL, best_usage = 0;
+  ll scored = 0, looping = 0;
+  while (!best && !candidates.empty()) {
+    size_t begin = split_pareto_layer(candidates);
+    candidate_batch batch;
+    for (size_t i = begin; i < candidates.size(); i++)
+      batch.push_back(candidates[i].a, candidates[i].b, 0, 0);
+    batch.score(original_route->a(), original_route->b(), k);
+    scored += batch.size();
+    vector<size_t> used;
+    for (size_t i = 0; i < batch.size(); i++)
+      if (batch.usages[i] > 0)
+        used.push_back(i);
+    sort(used.begin(), used.end(),
+         [&batch](size_t i, size_t j) { return batch.ots[i] < batch.ots[j]; });
+    for (size_t i : used) {
+      auto& candidate = candidates[begin + i];
+      auto links = via_path(candidate.v, forward[candidate.trees / 2],
+                            backward[candidate.trees % 2]);
+      if (links.empty()) {
+        looping++;
+        continue;
+      }
+      best = make_shared<route>(links);
+      best_ot = batch.ots[i];
+      best_usage = batch.usages[i];
+      break;
+    }
+    // an unused candidate is not worth the original route, nor is any candidate it beats
+    if (used.empty())
+      break;
+    candidates.resize(begin);
+  }
+  end = chrono::steady_clock::now();
+  ll via_us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+  cout << "Via candidates: " << count << " (" << plateau_nodes << " nodes on plateaus, " << scored
+       << " scored, " << looping << " skipped for loops)" << endl;
+  cout << "Via time: " << via_us << endl;
+  current_query.search_us += via_us;
+  current_query.pareto_set += scored;
+
+  if (!best)
+    cout << "Found no useful via-routes." << endl;
+  else
+    cout << "BEST VIA OT: " << best_ot << endl;
+  if (via_exact) {
+    start = chrono::steady_clock::now();
+    double exact = exact_ot(a, b, original_route, k, qot, inactive);
+    end = chrono::steady_clock::now();
+    double gap = (min(best_ot, qot) - exact) / exact;
+    gaps.groups++;
+    gaps.sum += gap;
+    gaps.max = max(gaps.max, gap);
+    gaps.via_us += via_us;
+    gaps.exact_us += chrono::duration_cast<chrono::microseconds>(end - start).count();
+    cout << "EXACT OT: " << exact << " gap: " << gap << endl;
+  }
+  if (!best || best_ot > qot)
+    return {original_route, 0.0};
+  cout << "a: " << best->a() << "  b: " << best->b() << endl;
+  return {best, best_usage};
+}
+
+void ssotd(int source, int destination, vector<int> pids, string optimization) {
+  start_deadline();
+  begin_query("via", source, destination, pids.size());
+  enter_od_corridor(source, destination);
+  shared_ptr<route> original_route = dijkstra(source, destination);
+    cout << "Length original: " << original_route->links.size() << endl;
+    cout << "d: " << pids.size() << endl;
+
+  auto start = chrono::steady_clock::now();
+  pair<shared_ptr<route>, double> ssotd_res =
+      ssotd_route(source, destination, original_route, pids.size(), optimization);
+  auto end = chrono::steady_clock::now();
+  cout << "time used: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << endl;
+  end_query(ssotd_res.first, original_route, ssotd_res.second);
+  double usage = ssotd_res.second / static_cast<double>(pids.size());
+  cout << "normalized usage of the pareto route: " << usage << endl;
+  for (int pid : pids)
+    if ((rand() % (1 << 16)) / static_cast<double>(1 << 16) < usage)
+      persons[pid].r = ssotd_res.first;
+    else
+      persons[pid].r = original_route;
+  leave_od_corridor(pids);
+}
+
+void do_routing(int argc, char* argv[]) {
+  string optimization = argc > 0 ? argv[0] : "none";
+  parse_ssotd_env();
+  // the trees need the exact distances, not lower bounds
+  if (bound_mode == "alt" || bound_mode == "geometric") {
+    cout << "The via variant needs exact distances, using SSOTD_BOUNDS=dijkstra" << endl;
+    bound_mode = "dijkstra";
+  }
+
+  for (auto& group : od_groups()) {
+    number_agents = group.pids.size();
+    ssotd(group.origin, group.destination, group.pids, optimization);
+  }
+  if (gaps.groups > 0)
+    cout << "Via gap over " << gaps.groups << " OD groups: mean " << gaps.sum / gaps.groups
+         << ", max " << gaps.max << ", via time " << gaps.via_us << ", exact time "
+         << gaps.exact_us << endl;
+}